@@ -21,6 +21,7 @@
 // SOFTWARE.
 
 #pragma once
+#include <ice/frame.h>
 #include <atomic>
 #include <exception>
 #include <experimental/coroutine>
@@ -35,6 +36,17 @@
 #include <utility>
 #include <cstddef>
 
+// Clang resumes coroutines returned from await_suspend with a tail call at every optimization level. Other compilers
+// may nest the call, so without symmetric transfer the awaiting coroutine starts the awaited one and continues without
+// suspending when it completed synchronously.
+#ifndef ICE_SYMMETRIC_TRANSFER
+#  ifdef __clang__
+#    define ICE_SYMMETRIC_TRANSFER 1
+#  else
+#    define ICE_SYMMETRIC_TRANSFER 0
+#  endif
+#endif
+
 namespace ice {
 
 struct exception_handler {
@@ -58,7 +70,7 @@ struct exception_handler {
 
 template <typename ExceptionHandler = exception_handler>
 struct basic_task {
-  struct promise_type {
+  struct promise_type : ice::frame_allocated {
     basic_task get_return_object() noexcept {
       return {};
     }
@@ -290,6 +302,18 @@ public:
     }
   }
 
+  // Returns the coroutine to transfer to from a final awaiter. Callbacks are called instead.
+  std::experimental::coroutine_handle<> transfer() noexcept {
+    if (m_callback == nullptr) {
+      if (m_state) {
+        return std::experimental::coroutine_handle<>::from_address(m_state);
+      }
+    } else {
+      m_callback(m_state);
+    }
+    return std::experimental::noop_coroutine();
+  }
+
 private:
   callback_t* m_callback = nullptr;
   void* m_state = nullptr;
@@ -304,7 +328,7 @@ class async;
 
 namespace detail {
 
-class async_promise_base {
+class async_promise_base : public ice::frame_allocated {
   friend struct final_awaitable;
 
   struct final_awaitable {
@@ -312,13 +336,25 @@ class async_promise_base {
       return false;
     }
 
+#if ICE_SYMMETRIC_TRANSFER
+    // Transfers to the awaiting coroutine instead of resuming it, so that chains of coroutines that complete
+    // synchronously run in constant stack space.
+    template <typename PROMISE>
+    std::experimental::coroutine_handle<> await_suspend(
+      std::experimental::coroutine_handle<PROMISE> coroutine) noexcept {
+      async_promise_base& promise = coroutine.promise();
+      promise.m_state.store(true, std::memory_order_relaxed);
+      return promise.m_continuation.transfer();
+    }
+#else
     template <typename PROMISE>
-    void await_suspend(std::experimental::coroutine_handle<PROMISE> coroutine) {
+    void await_suspend(std::experimental::coroutine_handle<PROMISE> coroutine) noexcept {
       async_promise_base& promise = coroutine.promise();
       if (promise.m_state.exchange(true, std::memory_order_acq_rel)) {
         promise.m_continuation.resume();
       }
     }
+#endif
 
     void await_resume() noexcept {
     }
@@ -340,10 +376,17 @@ public:
     m_exception = std::current_exception();
   }
 
+#if ICE_SYMMETRIC_TRANSFER
+  // Must be called before the coroutine is started, so that its completion can not race with the continuation.
+  void set_continuation(continuation c) noexcept {
+    m_continuation = c;
+  }
+#else
   bool try_set_continuation(continuation c) {
     m_continuation = c;
     return !m_state.exchange(true, std::memory_order_acq_rel);
   }
+#endif
 
 protected:
   bool completed() const noexcept {
@@ -459,10 +502,17 @@ private:
       return !m_coroutine || m_coroutine.done();
     }
 
+#if ICE_SYMMETRIC_TRANSFER
+    std::experimental::coroutine_handle<> await_suspend(std::experimental::coroutine_handle<> awaiter) noexcept {
+      m_coroutine.promise().set_continuation(detail::continuation{ awaiter });
+      return m_coroutine;
+    }
+#else
     bool await_suspend(std::experimental::coroutine_handle<> awaiter) noexcept {
       m_coroutine.resume();
       return m_coroutine.promise().try_set_continuation(detail::continuation{ awaiter });
     }
+#endif
   };
 
 public:
@@ -500,6 +550,21 @@ public:
     return !m_coroutine || m_coroutine.done();
   }
 
+  // Returns the result of the completed coroutine or rethrows its exception.
+  decltype(auto) result() & {
+    if (!m_coroutine) {
+      throw broken_promise{};
+    }
+    return m_coroutine.promise().result();
+  }
+
+  decltype(auto) result() && {
+    if (!m_coroutine) {
+      throw broken_promise{};
+    }
+    return std::move(m_coroutine.promise()).result();
+  }
+
   auto operator co_await() const& noexcept {
     struct awaitable : awaitable_base {
       using awaitable_base::awaitable_base;
@@ -548,10 +613,16 @@ public:
 
       void start(detail::continuation continuation) noexcept {
         if (m_coroutine && !m_coroutine.done()) {
+#if ICE_SYMMETRIC_TRANSFER
+          m_coroutine.promise().set_continuation(continuation);
+          m_coroutine.resume();
+          return;
+#else
           m_coroutine.resume();
           if (m_coroutine.promise().try_set_continuation(continuation)) {
             return;
           }
+#endif
         }
         continuation.resume();
       }
@@ -1128,4 +1199,110 @@ inline bool async_mutex_lock_operation::await_suspend(std::experimental::corouti
   }
 }
 
+// == include/cppcoro/async_scope.hpp ==================================================================================
+
+// Tracks spawned awaitables and lets a coroutine wait for all of them with co_await scope.join().
+// Spawned awaitables start immediately. The first exception thrown by a spawned awaitable is rethrown by join().
+// The scope must be joined before it is destroyed and no awaitables may be spawned after join() completed.
+class async_scope {
+public:
+  async_scope() noexcept : m_count(1u) {
+  }
+
+  async_scope(const async_scope&) = delete;
+  async_scope& operator=(const async_scope&) = delete;
+
+  ~async_scope() {
+    // The scope must be joined before it is destroyed.
+    assert(m_continuation);
+  }
+
+  template <typename AWAITABLE>
+  void spawn(AWAITABLE&& awaitable) {
+    m_count.fetch_add(1u, std::memory_order_relaxed);
+    run(this, std::forward<AWAITABLE>(awaitable));
+  }
+
+  [[nodiscard]] auto join() noexcept {
+    class join_awaiter {
+    public:
+      explicit join_awaiter(async_scope* scope) noexcept : m_scope(scope) {
+      }
+
+      bool await_ready() noexcept {
+        return m_scope->m_count.load(std::memory_order_acquire) == 0;
+      }
+
+      bool await_suspend(std::experimental::coroutine_handle<> continuation) noexcept {
+        m_scope->m_continuation = continuation;
+        return m_scope->m_count.fetch_sub(1u, std::memory_order_acq_rel) > 1u;
+      }
+
+      void await_resume() {
+        if (m_scope->m_exception) {
+          std::rethrow_exception(std::exchange(m_scope->m_exception, nullptr));
+        }
+      }
+
+    private:
+      async_scope* m_scope;
+    };
+
+    return join_awaiter{ this };
+  }
+
+private:
+  struct oneway_task {
+    struct promise_type : ice::frame_allocated {
+      std::experimental::suspend_never initial_suspend() noexcept {
+        return {};
+      }
+
+      std::experimental::suspend_never final_suspend() noexcept {
+        return {};
+      }
+
+      void unhandled_exception() noexcept {
+        std::terminate();
+      }
+
+      oneway_task get_return_object() noexcept {
+        return {};
+      }
+
+      void return_void() noexcept {
+      }
+    };
+  };
+
+  template <typename AWAITABLE>
+  static oneway_task run(async_scope* scope, AWAITABLE awaitable) {
+    try {
+      co_await std::move(awaitable);
+    }
+    catch (...) {
+      scope->on_exception(std::current_exception());
+    }
+    scope->on_work_finished();
+  }
+
+  void on_exception(std::exception_ptr exception) noexcept {
+    // Published to the joining coroutine by the release of the counter.
+    if (!m_failed.exchange(true, std::memory_order_relaxed)) {
+      m_exception = std::move(exception);
+    }
+  }
+
+  void on_work_finished() noexcept {
+    if (m_count.fetch_sub(1u, std::memory_order_acq_rel) == 1) {
+      m_continuation.resume();
+    }
+  }
+
+  std::atomic<std::size_t> m_count;
+  std::atomic<bool> m_failed = false;
+  std::exception_ptr m_exception;
+  std::experimental::coroutine_handle<> m_continuation;
+};
+
 }  // namespace ice
@@ -0,0 +1,406 @@
+#pragma once
+#include <experimental/coroutine>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+
+namespace ice {
+
+template <typename T>
+class async_channel;
+
+template <typename T>
+class async_channel_send_operation;
+
+template <typename T>
+class async_channel_recv_operation;
+
+namespace detail {
+
+// Suspended send or recv operation of an async channel.
+template <typename T>
+struct async_channel_waiter {
+  async_channel_waiter* next = nullptr;
+  std::experimental::coroutine_handle<> awaiter;
+  std::optional<T> value;
+  bool sent = false;
+};
+
+}  // namespace detail
+
+// Bounded multi-producer multi-consumer queue for coroutines.
+//
+// Values are stored in a lock-free ring buffer. Senders suspend while the channel is full and receivers suspend while
+// it is empty. Suspended operations are kept in lists that are only locked when an operation has to wait or when an
+// operation on the ring may have to resume a waiting one. Resumed operations continue on the thread that made room or
+// provided a value.
+template <typename T>
+class async_channel {
+public:
+  static_assert(std::is_nothrow_move_constructible_v<T>, "async_channel values must be nothrow move constructible");
+
+  using value_type = T;
+
+  explicit async_channel(std::size_t capacity) : capacity_(capacity) {
+    if (!capacity) {
+      throw std::invalid_argument("async_channel capacity must not be zero");
+    }
+    cells_ = std::make_unique<cell[]>(capacity);
+    for (std::size_t i = 0; i < capacity; i++) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  async_channel(async_channel&& other) = delete;
+  async_channel& operator=(async_channel&& other) = delete;
+
+  async_channel(const async_channel& other) = delete;
+  async_channel& operator=(const async_channel& other) = delete;
+
+  ~async_channel() {
+    std::optional<T> value;
+    while (pop(value)) {
+      value.reset();
+    }
+  }
+
+  constexpr std::size_t capacity() const noexcept {
+    return capacity_;
+  }
+
+  // Suspends while the channel is full. Resumes with false when the channel was closed before the value was sent.
+  [[nodiscard]] async_channel_send_operation<T> send(T value) noexcept(std::is_nothrow_move_constructible_v<T>);
+
+  // Suspends while the channel is empty. Resumes with std::nullopt when the channel was closed and is empty.
+  [[nodiscard]] async_channel_recv_operation<T> recv() noexcept;
+
+  // Sends a value without waiting. Returns false when the channel is full or closed.
+  bool try_send(T& value) noexcept {
+    if (closed_.load(std::memory_order_acquire) || !push(value)) {
+      return false;
+    }
+    notify_receivers();
+    return true;
+  }
+
+  // Receives a value without waiting. Returns std::nullopt when the channel is empty.
+  std::optional<T> try_recv() noexcept {
+    std::optional<T> value;
+    if (pop(value)) {
+      notify_senders();
+    }
+    return value;
+  }
+
+  // Makes pending and future sends fail and resumes receivers that wait on the empty channel.
+  // Values that were sent before are still received.
+  void close() noexcept {
+    waiter* resume = nullptr;
+    {
+      std::lock_guard lock(mutex_);
+      closed_.store(true, std::memory_order_release);
+      for (auto& list : { &senders_, &receivers_ }) {
+        while (const auto entry = list->pop()) {
+          entry->next = resume;
+          resume = entry;
+        }
+      }
+      send_waiters_.store(0, std::memory_order_relaxed);
+      recv_waiters_.store(0, std::memory_order_relaxed);
+    }
+    this->resume(resume);
+  }
+
+  bool closed() const noexcept {
+    return closed_.load(std::memory_order_acquire);
+  }
+
+private:
+  friend class async_channel_send_operation<T>;
+  friend class async_channel_recv_operation<T>;
+
+  using waiter = detail::async_channel_waiter<T>;
+
+  struct cell {
+    std::atomic<std::size_t> sequence = 0;
+    alignas(T) unsigned char storage[sizeof(T)];
+  };
+
+  // First in, first out list of suspended operations.
+  struct waiter_list {
+    void push(waiter* entry) noexcept {
+      entry->next = nullptr;
+      if (tail) {
+        tail->next = entry;
+      } else {
+        head = entry;
+      }
+      tail = entry;
+    }
+
+    waiter* pop() noexcept {
+      const auto entry = head;
+      if (entry) {
+        head = entry->next;
+        if (!head) {
+          tail = nullptr;
+        }
+      }
+      return entry;
+    }
+
+    waiter* head = nullptr;
+    waiter* tail = nullptr;
+  };
+
+  // Moves the value into the ring buffer unless it is full.
+  bool push(T& value) noexcept {
+    auto position = tail_.load(std::memory_order_relaxed);
+    while (true) {
+      auto& entry = cells_[position % capacity_];
+      const auto sequence = entry.sequence.load(std::memory_order_acquire);
+      const auto difference = static_cast<std::intptr_t>(sequence - position);
+      if (difference == 0) {
+        if (tail_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+          new (static_cast<void*>(entry.storage)) T(std::move(value));
+          entry.sequence.store(position + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (difference < 0) {
+        return false;
+      } else {
+        position = tail_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Moves a value out of the ring buffer unless it is empty.
+  bool pop(std::optional<T>& value) noexcept {
+    auto position = head_.load(std::memory_order_relaxed);
+    while (true) {
+      auto& entry = cells_[position % capacity_];
+      const auto sequence = entry.sequence.load(std::memory_order_acquire);
+      const auto difference = static_cast<std::intptr_t>(sequence - (position + 1));
+      if (difference == 0) {
+        if (head_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+          auto& item = *std::launder(reinterpret_cast<T*>(entry.storage));
+          value.emplace(std::move(item));
+          item.~T();
+          entry.sequence.store(position + capacity_, std::memory_order_release);
+          return true;
+        }
+      } else if (difference < 0) {
+        return false;
+      } else {
+        position = head_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Each side announces a waiting operation before it checks the ring buffer for the last time and the other side
+  // checks for waiting operations after it changed the ring buffer, so that one of them sees the other.
+  void notify_receivers() noexcept {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (recv_waiters_.load(std::memory_order_relaxed)) {
+      transfer();
+    }
+  }
+
+  void notify_senders() noexcept {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (send_waiters_.load(std::memory_order_relaxed)) {
+      transfer();
+    }
+  }
+
+  void transfer() noexcept {
+    waiter* resume = nullptr;
+    {
+      std::lock_guard lock(mutex_);
+      resume = pump();
+    }
+    this->resume(resume);
+  }
+
+  // Moves values between the ring buffer and waiting operations. Must be called with the mutex locked.
+  // Returns the operations that completed.
+  waiter* pump() noexcept {
+    waiter* resume = nullptr;
+    auto progress = true;
+    while (progress) {
+      progress = false;
+      if (receivers_.head && pop(receivers_.head->value)) {
+        const auto entry = receivers_.pop();
+        recv_waiters_.fetch_sub(1, std::memory_order_relaxed);
+        entry->next = resume;
+        resume = entry;
+        progress = true;
+      }
+      if (senders_.head && push(*senders_.head->value)) {
+        const auto entry = senders_.pop();
+        send_waiters_.fetch_sub(1, std::memory_order_relaxed);
+        entry->sent = true;
+        entry->next = resume;
+        resume = entry;
+        progress = true;
+      }
+    }
+    return resume;
+  }
+
+  void resume(waiter* entry) noexcept {
+    while (entry) {
+      const auto next = entry->next;
+      entry->awaiter.resume();
+      entry = next;
+    }
+  }
+
+  // Returns true when the send completed without waiting.
+  bool send_ready(waiter& entry) noexcept {
+    if (closed_.load(std::memory_order_acquire)) {
+      return true;
+    }
+    if (push(*entry.value)) {
+      entry.sent = true;
+      notify_receivers();
+      return true;
+    }
+    return false;
+  }
+
+  // Returns false when the send completed without waiting.
+  bool send_suspend(waiter& entry) noexcept {
+    waiter* resume = nullptr;
+    auto suspended = false;
+    {
+      std::lock_guard lock(mutex_);
+      if (!closed_.load(std::memory_order_relaxed)) {
+        send_waiters_.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (push(*entry.value)) {
+          send_waiters_.fetch_sub(1, std::memory_order_relaxed);
+          entry.sent = true;
+          resume = pump();
+        } else {
+          senders_.push(&entry);
+          suspended = true;
+        }
+      }
+    }
+    this->resume(resume);
+    return suspended;
+  }
+
+  // Returns true when the recv completed without waiting.
+  bool recv_ready(waiter& entry) noexcept {
+    if (pop(entry.value)) {
+      notify_senders();
+      return true;
+    }
+    return closed_.load(std::memory_order_acquire);
+  }
+
+  // Returns false when the recv completed without waiting.
+  bool recv_suspend(waiter& entry) noexcept {
+    waiter* resume = nullptr;
+    auto suspended = false;
+    {
+      std::lock_guard lock(mutex_);
+      recv_waiters_.fetch_add(1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (pop(entry.value)) {
+        recv_waiters_.fetch_sub(1, std::memory_order_relaxed);
+        resume = pump();
+      } else if (closed_.load(std::memory_order_relaxed)) {
+        recv_waiters_.fetch_sub(1, std::memory_order_relaxed);
+      } else {
+        receivers_.push(&entry);
+        suspended = true;
+      }
+    }
+    this->resume(resume);
+    return suspended;
+  }
+
+  const std::size_t capacity_;
+  std::unique_ptr<cell[]> cells_;
+  alignas(64) std::atomic<std::size_t> head_ = 0;
+  alignas(64) std::atomic<std::size_t> tail_ = 0;
+  alignas(64) std::atomic<std::size_t> send_waiters_ = 0;
+  std::atomic<std::size_t> recv_waiters_ = 0;
+  std::atomic<bool> closed_ = false;
+  std::mutex mutex_;
+  waiter_list senders_;
+  waiter_list receivers_;
+};
+
+template <typename T>
+class async_channel_send_operation {
+public:
+  async_channel_send_operation(async_channel<T>& channel, T value) noexcept(std::is_nothrow_move_constructible_v<T>) :
+    channel_(channel) {
+    waiter_.value.emplace(std::move(value));
+  }
+
+  bool await_ready() noexcept {
+    return channel_.send_ready(waiter_);
+  }
+
+  bool await_suspend(std::experimental::coroutine_handle<> awaiter) noexcept {
+    waiter_.awaiter = awaiter;
+    return channel_.send_suspend(waiter_);
+  }
+
+  bool await_resume() const noexcept {
+    return waiter_.sent;
+  }
+
+private:
+  async_channel<T>& channel_;
+  detail::async_channel_waiter<T> waiter_;
+};
+
+template <typename T>
+class async_channel_recv_operation {
+public:
+  explicit async_channel_recv_operation(async_channel<T>& channel) noexcept : channel_(channel) {
+  }
+
+  bool await_ready() noexcept {
+    return channel_.recv_ready(waiter_);
+  }
+
+  bool await_suspend(std::experimental::coroutine_handle<> awaiter) noexcept {
+    waiter_.awaiter = awaiter;
+    return channel_.recv_suspend(waiter_);
+  }
+
+  std::optional<T> await_resume() noexcept {
+    return std::move(waiter_.value);
+  }
+
+private:
+  async_channel<T>& channel_;
+  detail::async_channel_waiter<T> waiter_;
+};
+
+template <typename T>
+inline async_channel_send_operation<T> async_channel<T>::send(T value) noexcept(
+  std::is_nothrow_move_constructible_v<T>) {
+  return async_channel_send_operation<T>{ *this, std::move(value) };
+}
+
+template <typename T>
+inline async_channel_recv_operation<T> async_channel<T>::recv() noexcept {
+  return async_channel_recv_operation<T>{ *this };
+}
+
+}  // namespace ice
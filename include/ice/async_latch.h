@@ -0,0 +1,102 @@
+#pragma once
+#include <experimental/coroutine>
+#include <atomic>
+#include <cstddef>
+
+namespace ice {
+
+class async_latch;
+
+class async_latch_wait_operation {
+public:
+  explicit async_latch_wait_operation(async_latch& latch) noexcept : latch_(latch) {
+  }
+
+  bool await_ready() const noexcept;
+  bool await_suspend(std::experimental::coroutine_handle<> awaiter) noexcept;
+
+  constexpr void await_resume() const noexcept {
+  }
+
+private:
+  friend class async_latch;
+
+  async_latch& latch_;
+  async_latch_wait_operation* next_ = nullptr;
+  std::experimental::coroutine_handle<> awaiter_;
+};
+
+// Single-use countdown for fan-in. Waiting operations are resumed on the thread that counts down to zero.
+//
+// Like async_mutex, waiting operations are pushed to a lock-free stack. The state holds the address of the latch once
+// it is ready, so that no operation can be pushed after the stack was taken.
+class async_latch {
+public:
+  explicit async_latch(std::ptrdiff_t count) noexcept : count_(count), state_(count > 0 ? nullptr : this) {
+  }
+
+  async_latch(const async_latch& other) = delete;
+  async_latch& operator=(const async_latch& other) = delete;
+
+  bool is_ready() const noexcept {
+    return state_.load(std::memory_order_acquire) == static_cast<const void*>(this);
+  }
+
+  // Decrements the counter and resumes waiting operations when it reaches zero.
+  void count_down(std::ptrdiff_t count = 1) noexcept {
+    if (count_.fetch_sub(count, std::memory_order_acq_rel) <= count) {
+      set();
+    }
+  }
+
+  // Suspends until the counter reaches zero.
+  async_latch_wait_operation operator co_await() noexcept {
+    return async_latch_wait_operation{ *this };
+  }
+
+  // Decrements the counter and suspends until it reaches zero. Behaves like a single-use barrier.
+  async_latch_wait_operation arrive_and_wait(std::ptrdiff_t count = 1) noexcept {
+    count_down(count);
+    return async_latch_wait_operation{ *this };
+  }
+
+private:
+  friend class async_latch_wait_operation;
+
+  void set() noexcept {
+    auto state = state_.exchange(this, std::memory_order_acq_rel);
+    if (state == static_cast<void*>(this)) {
+      return;
+    }
+    auto operation = static_cast<async_latch_wait_operation*>(state);
+    while (operation) {
+      const auto next = operation->next_;
+      operation->awaiter_.resume();
+      operation = next;
+    }
+  }
+
+  std::atomic<std::ptrdiff_t> count_;
+
+  // Holds the address of the latch when it is ready and the most recently suspended operation otherwise.
+  std::atomic<void*> state_;
+};
+
+inline bool async_latch_wait_operation::await_ready() const noexcept {
+  return latch_.is_ready();
+}
+
+inline bool async_latch_wait_operation::await_suspend(std::experimental::coroutine_handle<> awaiter) noexcept {
+  awaiter_ = awaiter;
+  const void* const ready = &latch_;
+  auto state = latch_.state_.load(std::memory_order_acquire);
+  do {
+    if (state == ready) {
+      return false;
+    }
+    next_ = static_cast<async_latch_wait_operation*>(state);
+  } while (!latch_.state_.compare_exchange_weak(state, this, std::memory_order_release, std::memory_order_acquire));
+  return true;
+}
+
+}  // namespace ice
@@ -0,0 +1,237 @@
+#pragma once
+#include <experimental/coroutine>
+#include <atomic>
+#include <utility>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+namespace ice {
+
+class async_semaphore;
+class async_semaphore_acquire_operation;
+class async_semaphore_scoped_acquire_operation;
+
+// Releases a permit when destroyed.
+class async_semaphore_permit {
+public:
+  explicit async_semaphore_permit(async_semaphore& semaphore) noexcept : semaphore_(&semaphore) {
+  }
+
+  async_semaphore_permit(async_semaphore_permit&& other) noexcept :
+    semaphore_(std::exchange(other.semaphore_, nullptr)) {
+  }
+
+  async_semaphore_permit(const async_semaphore_permit& other) = delete;
+  async_semaphore_permit& operator=(const async_semaphore_permit& other) = delete;
+
+  ~async_semaphore_permit();
+
+private:
+  async_semaphore* semaphore_;
+};
+
+// Counting semaphore for coroutines.
+//
+// Like async_mutex, the state is a single word. It holds the number of available permits while no operation waits and
+// a stack of waiting operations otherwise. Releasing threads take the whole stack, resume as many operations as they
+// have permits for and put the rest back. Waiting operations are resumed on the releasing thread, but not necessarily
+// in the order they started waiting.
+class async_semaphore {
+public:
+  explicit async_semaphore(std::size_t permits) noexcept : state_(encode(permits)) {
+  }
+
+  async_semaphore(const async_semaphore& other) = delete;
+  async_semaphore& operator=(const async_semaphore& other) = delete;
+
+  ~async_semaphore() {
+    assert(state_.load(std::memory_order_relaxed) & 1);
+  }
+
+  // Takes a permit without waiting. Returns false when none is available.
+  bool try_acquire() noexcept {
+    auto state = state_.load(std::memory_order_acquire);
+    while ((state & 1) && decode(state)) {
+      if (state_.compare_exchange_weak(state, state - 2, std::memory_order_acquire, std::memory_order_acquire)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Waits for a permit that must be returned with release().
+  [[nodiscard]] async_semaphore_acquire_operation acquire() noexcept;
+
+  // Waits for a permit that is returned when the resulting object is destroyed.
+  [[nodiscard]] async_semaphore_scoped_acquire_operation scoped_acquire() noexcept;
+
+  // Returns permits and resumes waiting operations.
+  void release(std::size_t count = 1) noexcept;
+
+private:
+  friend class async_semaphore_acquire_operation;
+
+  constexpr static std::uintptr_t encode(std::size_t permits) noexcept {
+    return (static_cast<std::uintptr_t>(permits) << 1) | 1;
+  }
+
+  constexpr static std::size_t decode(std::uintptr_t state) noexcept {
+    return static_cast<std::size_t>(state >> 1);
+  }
+
+  bool suspend(async_semaphore_acquire_operation* operation) noexcept;
+
+  // Holds the number of permits when the lowest bit is set and a pointer to the most recently suspended operation
+  // otherwise.
+  std::atomic<std::uintptr_t> state_;
+};
+
+class async_semaphore_acquire_operation {
+public:
+  explicit async_semaphore_acquire_operation(async_semaphore& semaphore) noexcept : semaphore_(semaphore) {
+  }
+
+  bool await_ready() const noexcept {
+    return semaphore_.try_acquire();
+  }
+
+  bool await_suspend(std::experimental::coroutine_handle<> awaiter) noexcept {
+    awaiter_ = awaiter;
+    return semaphore_.suspend(this);
+  }
+
+  constexpr void await_resume() const noexcept {
+  }
+
+protected:
+  friend class async_semaphore;
+
+  async_semaphore& semaphore_;
+  async_semaphore_acquire_operation* next_ = nullptr;
+  std::experimental::coroutine_handle<> awaiter_;
+};
+
+class async_semaphore_scoped_acquire_operation : public async_semaphore_acquire_operation {
+public:
+  using async_semaphore_acquire_operation::async_semaphore_acquire_operation;
+
+  [[nodiscard]] async_semaphore_permit await_resume() const noexcept {
+    return async_semaphore_permit{ semaphore_ };
+  }
+};
+
+inline async_semaphore_permit::~async_semaphore_permit() {
+  if (semaphore_) {
+    semaphore_->release();
+  }
+}
+
+inline async_semaphore_acquire_operation async_semaphore::acquire() noexcept {
+  return async_semaphore_acquire_operation{ *this };
+}
+
+inline async_semaphore_scoped_acquire_operation async_semaphore::scoped_acquire() noexcept {
+  return async_semaphore_scoped_acquire_operation{ *this };
+}
+
+inline bool async_semaphore::suspend(async_semaphore_acquire_operation* operation) noexcept {
+  auto state = state_.load(std::memory_order_acquire);
+  while (true) {
+    if (state & 1) {
+      if (decode(state)) {
+        if (state_.compare_exchange_weak(state, state - 2, std::memory_order_acquire, std::memory_order_acquire)) {
+          return false;
+        }
+        continue;
+      }
+      operation->next_ = nullptr;
+    } else {
+      operation->next_ = reinterpret_cast<async_semaphore_acquire_operation*>(state);
+    }
+    if (state_.compare_exchange_weak(state, reinterpret_cast<std::uintptr_t>(operation), std::memory_order_release,
+          std::memory_order_acquire)) {
+      return true;
+    }
+  }
+}
+
+inline void async_semaphore::release(std::size_t count) noexcept {
+  // Operations taken from the state in the order they started waiting and operations that got a permit.
+  async_semaphore_acquire_operation* waiting = nullptr;
+  async_semaphore_acquire_operation* resume = nullptr;
+  auto state = state_.load(std::memory_order_acquire);
+  while (true) {
+    while (count && waiting) {
+      const auto operation = waiting;
+      waiting = waiting->next_;
+      operation->next_ = resume;
+      resume = operation;
+      count--;
+    }
+    if (!(state & 1)) {
+      // Take the stack. Operations are only read after they were taken, so they may be pushed again concurrently.
+      if (state_.compare_exchange_weak(state, encode(0), std::memory_order_acq_rel, std::memory_order_acquire)) {
+        auto operation = reinterpret_cast<async_semaphore_acquire_operation*>(state);
+        async_semaphore_acquire_operation* taken = nullptr;
+        while (operation) {
+          const auto next = operation->next_;
+          operation->next_ = taken;
+          taken = operation;
+          operation = next;
+        }
+        if (waiting) {
+          auto last = waiting;
+          while (last->next_) {
+            last = last->next_;
+          }
+          last->next_ = taken;
+        } else {
+          waiting = taken;
+        }
+        state = encode(0);
+      }
+      continue;
+    }
+    if (!waiting) {
+      if (state_.compare_exchange_weak(
+            state, state + encode(count) - 1, std::memory_order_release, std::memory_order_acquire)) {
+        break;
+      }
+      continue;
+    }
+    if (decode(state)) {
+      // Take the permits that were returned concurrently for the operations that still wait.
+      if (state_.compare_exchange_weak(state, encode(0), std::memory_order_acq_rel, std::memory_order_acquire)) {
+        count += decode(state);
+        state = encode(0);
+      }
+      continue;
+    }
+    // Put the remaining operations back in reverse, so that the next releasing thread resumes them in order.
+    async_semaphore_acquire_operation* stack = nullptr;
+    while (waiting) {
+      const auto next = waiting->next_;
+      waiting->next_ = stack;
+      stack = waiting;
+      waiting = next;
+    }
+    if (state_.compare_exchange_strong(
+          state, reinterpret_cast<std::uintptr_t>(stack), std::memory_order_release, std::memory_order_acquire)) {
+      break;
+    }
+    while (stack) {
+      const auto next = stack->next_;
+      stack->next_ = waiting;
+      waiting = stack;
+      stack = next;
+    }
+  }
+  while (resume) {
+    const auto next = resume->next_;
+    resume->awaiter_.resume();
+    resume = next;
+  }
+}
+
+}  // namespace ice
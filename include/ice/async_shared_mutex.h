@@ -0,0 +1,320 @@
+#pragma once
+#include <experimental/coroutine>
+#include <atomic>
+#include <mutex>
+#include <utility>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+namespace ice {
+
+class async_shared_mutex;
+class async_shared_mutex_lock_operation;
+class async_shared_mutex_scoped_lock_operation;
+class async_shared_mutex_scoped_lock_shared_operation;
+
+// Unlocks the mutex when destroyed.
+class async_shared_mutex_lock {
+public:
+  explicit async_shared_mutex_lock(async_shared_mutex& mutex, std::adopt_lock_t) noexcept : mutex_(&mutex) {
+  }
+
+  async_shared_mutex_lock(async_shared_mutex_lock&& other) noexcept : mutex_(std::exchange(other.mutex_, nullptr)) {
+  }
+
+  async_shared_mutex_lock(const async_shared_mutex_lock& other) = delete;
+  async_shared_mutex_lock& operator=(const async_shared_mutex_lock& other) = delete;
+
+  ~async_shared_mutex_lock();
+
+private:
+  async_shared_mutex* mutex_;
+};
+
+// Unlocks a shared ownership of the mutex when destroyed.
+class async_shared_mutex_shared_lock {
+public:
+  explicit async_shared_mutex_shared_lock(async_shared_mutex& mutex, std::adopt_lock_t) noexcept : mutex_(&mutex) {
+  }
+
+  async_shared_mutex_shared_lock(async_shared_mutex_shared_lock&& other) noexcept :
+    mutex_(std::exchange(other.mutex_, nullptr)) {
+  }
+
+  async_shared_mutex_shared_lock(const async_shared_mutex_shared_lock& other) = delete;
+  async_shared_mutex_shared_lock& operator=(const async_shared_mutex_shared_lock& other) = delete;
+
+  ~async_shared_mutex_shared_lock();
+
+private:
+  async_shared_mutex* mutex_;
+};
+
+// Reader-writer mutex for coroutines.
+//
+// Like async_mutex, the state is a single word. While no operation waits, it holds the number of readers and whether
+// a writer owns the mutex. Otherwise it holds a stack of operations that started waiting and the number of readers is
+// kept separately. The last owner to unlock takes the stack and hands the mutex to the oldest waiting writer or to all
+// readers that waited in front of the next writer. Readers wait once a writer waits, so that writers are not starved.
+class async_shared_mutex {
+public:
+  async_shared_mutex() noexcept = default;
+
+  async_shared_mutex(const async_shared_mutex& other) = delete;
+  async_shared_mutex& operator=(const async_shared_mutex& other) = delete;
+
+  ~async_shared_mutex() {
+    assert(state_.load(std::memory_order_relaxed) == unlocked);
+    assert(!waiters_);
+  }
+
+  bool try_lock() noexcept {
+    auto state = unlocked;
+    return state_.compare_exchange_strong(state, locked, std::memory_order_acquire, std::memory_order_relaxed);
+  }
+
+  bool try_lock_shared() noexcept {
+    auto state = state_.load(std::memory_order_acquire);
+    while ((state & 1) && !(state & exclusive)) {
+      if (state_.compare_exchange_weak(state, state + reader, std::memory_order_acquire, std::memory_order_acquire)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Waits for exclusive ownership that must be returned with unlock().
+  [[nodiscard]] async_shared_mutex_lock_operation lock_async() noexcept;
+
+  // Waits for shared ownership that must be returned with unlock_shared().
+  [[nodiscard]] async_shared_mutex_lock_operation lock_shared_async() noexcept;
+
+  // Waits for exclusive ownership that is returned when the resulting lock is destroyed.
+  [[nodiscard]] async_shared_mutex_scoped_lock_operation scoped_lock_async() noexcept;
+
+  // Waits for shared ownership that is returned when the resulting lock is destroyed.
+  [[nodiscard]] async_shared_mutex_scoped_lock_shared_operation scoped_lock_shared_async() noexcept;
+
+  void unlock() noexcept {
+    auto state = locked;
+    if (!state_.compare_exchange_strong(state, unlocked, std::memory_order_release, std::memory_order_relaxed)) {
+      resume(handoff());
+    }
+  }
+
+  void unlock_shared() noexcept {
+    auto state = state_.load(std::memory_order_relaxed);
+    while (state & 1) {
+      assert(state >= reader);
+      if (state_.compare_exchange_weak(state, state - reader, std::memory_order_release, std::memory_order_relaxed)) {
+        return;
+      }
+    }
+    if (readers_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      resume(handoff());
+    }
+  }
+
+private:
+  friend class async_shared_mutex_lock_operation;
+
+  // Values of the state while no operation waits. Readers are counted from the third bit.
+  constexpr static std::uintptr_t unlocked = 1;
+  constexpr static std::uintptr_t exclusive = 2;
+  constexpr static std::uintptr_t locked = unlocked | exclusive;
+  constexpr static std::uintptr_t reader = 4;
+
+  // Value of the state while operations wait and no operation started waiting since the last handoff.
+  constexpr static std::uintptr_t waiting = 0;
+
+  bool suspend(async_shared_mutex_lock_operation* operation) noexcept;
+
+  // Hands the mutex to the next waiting operations. Must be called by the last owner.
+  // Returns the operations that must be resumed.
+  async_shared_mutex_lock_operation* handoff() noexcept;
+
+  static void resume(async_shared_mutex_lock_operation* operation) noexcept;
+
+  // Holds the values above or the most recently suspended operation.
+  std::atomic<std::uintptr_t> state_ = unlocked;
+
+  // Number of readers that own the mutex while the state does not count them.
+  // Can drop below zero while a writer moves the readers out of the state.
+  std::atomic<std::ptrdiff_t> readers_ = 0;
+
+  // Operations that waited in front of the state in the order they started waiting. Only accessed by the last owner.
+  async_shared_mutex_lock_operation* waiters_ = nullptr;
+};
+
+class async_shared_mutex_lock_operation {
+public:
+  async_shared_mutex_lock_operation(async_shared_mutex& mutex, bool shared) noexcept : mutex_(mutex), shared_(shared) {
+  }
+
+  bool await_ready() const noexcept {
+    return shared_ ? mutex_.try_lock_shared() : mutex_.try_lock();
+  }
+
+  bool await_suspend(std::experimental::coroutine_handle<> awaiter) noexcept {
+    awaiter_ = awaiter;
+    return mutex_.suspend(this);
+  }
+
+  constexpr void await_resume() const noexcept {
+  }
+
+protected:
+  friend class async_shared_mutex;
+
+  async_shared_mutex& mutex_;
+  const bool shared_;
+  async_shared_mutex_lock_operation* next_ = nullptr;
+  std::experimental::coroutine_handle<> awaiter_;
+};
+
+class async_shared_mutex_scoped_lock_operation : public async_shared_mutex_lock_operation {
+public:
+  explicit async_shared_mutex_scoped_lock_operation(async_shared_mutex& mutex) noexcept :
+    async_shared_mutex_lock_operation(mutex, false) {
+  }
+
+  [[nodiscard]] async_shared_mutex_lock await_resume() const noexcept {
+    return async_shared_mutex_lock{ mutex_, std::adopt_lock };
+  }
+};
+
+class async_shared_mutex_scoped_lock_shared_operation : public async_shared_mutex_lock_operation {
+public:
+  explicit async_shared_mutex_scoped_lock_shared_operation(async_shared_mutex& mutex) noexcept :
+    async_shared_mutex_lock_operation(mutex, true) {
+  }
+
+  [[nodiscard]] async_shared_mutex_shared_lock await_resume() const noexcept {
+    return async_shared_mutex_shared_lock{ mutex_, std::adopt_lock };
+  }
+};
+
+inline async_shared_mutex_lock::~async_shared_mutex_lock() {
+  if (mutex_) {
+    mutex_->unlock();
+  }
+}
+
+inline async_shared_mutex_shared_lock::~async_shared_mutex_shared_lock() {
+  if (mutex_) {
+    mutex_->unlock_shared();
+  }
+}
+
+inline async_shared_mutex_lock_operation async_shared_mutex::lock_async() noexcept {
+  return async_shared_mutex_lock_operation{ *this, false };
+}
+
+inline async_shared_mutex_lock_operation async_shared_mutex::lock_shared_async() noexcept {
+  return async_shared_mutex_lock_operation{ *this, true };
+}
+
+inline async_shared_mutex_scoped_lock_operation async_shared_mutex::scoped_lock_async() noexcept {
+  return async_shared_mutex_scoped_lock_operation{ *this };
+}
+
+inline async_shared_mutex_scoped_lock_shared_operation async_shared_mutex::scoped_lock_shared_async() noexcept {
+  return async_shared_mutex_scoped_lock_shared_operation{ *this };
+}
+
+inline bool async_shared_mutex::suspend(async_shared_mutex_lock_operation* operation) noexcept {
+  auto state = state_.load(std::memory_order_acquire);
+  while (true) {
+    std::uintptr_t readers = 0;
+    if (state & 1) {
+      if (state == unlocked || (operation->shared_ && !(state & exclusive))) {
+        const auto value = state == unlocked && !operation->shared_ ? locked : state + reader;
+        if (state_.compare_exchange_weak(state, value, std::memory_order_acquire, std::memory_order_acquire)) {
+          return false;
+        }
+        continue;
+      }
+      readers = state >> 2;
+      operation->next_ = nullptr;
+    } else {
+      operation->next_ = reinterpret_cast<async_shared_mutex_lock_operation*>(state);
+    }
+    if (!state_.compare_exchange_weak(state, reinterpret_cast<std::uintptr_t>(operation), std::memory_order_acq_rel,
+          std::memory_order_acquire)) {
+      continue;
+    }
+    if (!readers) {
+      return true;
+    }
+    // The readers moved out of the state. Hand the mutex over when they all unlocked in the meantime.
+    const auto count = static_cast<std::ptrdiff_t>(readers);
+    if (readers_.fetch_add(count, std::memory_order_acq_rel) + count != 0) {
+      return true;
+    }
+    auto resume = handoff();
+    auto suspend = true;
+    for (auto entry = &resume; *entry; entry = &(*entry)->next_) {
+      if (*entry == operation) {
+        *entry = operation->next_;
+        suspend = false;
+        break;
+      }
+    }
+    this->resume(resume);
+    return suspend;
+  }
+}
+
+inline async_shared_mutex_lock_operation* async_shared_mutex::handoff() noexcept {
+  while (!waiters_) {
+    auto state = state_.load(std::memory_order_acquire);
+    if (state == waiting) {
+      if (state_.compare_exchange_weak(state, unlocked, std::memory_order_release, std::memory_order_relaxed)) {
+        return nullptr;
+      }
+      continue;
+    }
+    // Take the stack. Operations are only read after they were taken, so they may be pushed again concurrently.
+    if (state_.compare_exchange_weak(state, waiting, std::memory_order_acquire, std::memory_order_relaxed)) {
+      auto operation = reinterpret_cast<async_shared_mutex_lock_operation*>(state);
+      while (operation) {
+        const auto next = operation->next_;
+        operation->next_ = waiters_;
+        waiters_ = operation;
+        operation = next;
+      }
+    }
+  }
+  auto resume = waiters_;
+  auto last = waiters_;
+  std::ptrdiff_t readers = 0;
+  if (last->shared_) {
+    readers++;
+    while (last->next_ && last->next_->shared_) {
+      last = last->next_;
+      readers++;
+    }
+  }
+  waiters_ = last->next_;
+  last->next_ = nullptr;
+  if (!waiters_) {
+    auto state = waiting;
+    const auto value = readers ? unlocked + static_cast<std::uintptr_t>(readers) * reader : locked;
+    if (state_.compare_exchange_strong(state, value, std::memory_order_release, std::memory_order_relaxed)) {
+      return resume;
+    }
+  }
+  readers_.store(readers, std::memory_order_release);
+  return resume;
+}
+
+inline void async_shared_mutex::resume(async_shared_mutex_lock_operation* operation) noexcept {
+  while (operation) {
+    const auto next = operation->next_;
+    operation->awaiter_.resume();
+    operation = next;
+  }
+}
+
+}  // namespace ice
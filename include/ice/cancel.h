@@ -0,0 +1,115 @@
+#pragma once
+#include <ice/config.h>
+#include <ice/error.h>
+#include <ice/event.h>
+#include <atomic>
+#include <memory>
+#include <utility>
+
+namespace ice {
+namespace detail {
+
+class cancellation_state;
+
+}  // namespace detail
+
+class cancellation_registration;
+
+// Lets operations observe the cancellation requests of a cancellation source.
+class cancellation_token {
+public:
+  cancellation_token() noexcept = default;
+
+  // Returns false when the token is not associated with a cancellation source.
+  bool can_be_canceled() const noexcept {
+    return state_ != nullptr;
+  }
+
+  bool is_canceled() const noexcept;
+
+private:
+  friend class cancellation_source;
+  friend class cancellation_registration;
+
+  explicit cancellation_token(std::shared_ptr<detail::cancellation_state> state) noexcept : state_(std::move(state)) {
+  }
+
+  std::shared_ptr<detail::cancellation_state> state_;
+};
+
+// Cancels the operations that were started with its tokens.
+class cancellation_source {
+public:
+  cancellation_source();
+
+  cancellation_token token() const noexcept {
+    return cancellation_token{ state_ };
+  }
+
+  // Completes pending and future operations with std::errc::operation_canceled.
+  // Returns false when cancellation was already requested.
+  bool cancel() noexcept;
+
+  bool is_canceled() const noexcept;
+
+private:
+  std::shared_ptr<detail::cancellation_state> state_;
+};
+
+// Cancels an event with std::errc::operation_canceled when its token is canceled while the operation is pending.
+// Operations start the registration when they suspend and stop it before they complete.
+class cancellation_registration {
+public:
+  explicit cancellation_registration(ice::event& ev) noexcept : event_(ev) {
+  }
+
+  cancellation_registration(ice::event& ev, cancellation_token token) noexcept :
+    event_(ev), state_(std::move(token.state_)) {
+  }
+
+  cancellation_registration(cancellation_registration&& other) = delete;
+  cancellation_registration& operator=(cancellation_registration&& other) = delete;
+
+  cancellation_registration(const cancellation_registration& other) = delete;
+  cancellation_registration& operator=(const cancellation_registration& other) = delete;
+
+  ~cancellation_registration() {
+    stop();
+  }
+
+  bool enabled() const noexcept {
+    return state_ != nullptr;
+  }
+
+  // Registers the event with the token unless it has none or is already registered.
+  void start() noexcept {
+    if (state_ && !started_) {
+      started_ = true;
+      add();
+    }
+  }
+
+  // Unregisters the event or waits for the thread that cancels it.
+  void stop() noexcept {
+    if (started_) {
+      started_ = false;
+      remove();
+    }
+  }
+
+private:
+  friend class detail::cancellation_state;
+
+  void add() noexcept;
+  void remove() noexcept;
+
+  ice::event& event_;
+  std::shared_ptr<detail::cancellation_state> state_;
+  cancellation_registration* prev_ = nullptr;
+  cancellation_registration* next_ = nullptr;
+  std::atomic_bool canceled_ = false;
+  bool linked_ = false;
+  bool started_ = false;
+};
+
+}  // namespace ice
@@ -23,6 +23,12 @@
 #  define ICE_OS_FREEBSD 0
 #endif
 
+#if ICE_OS_LINUX
+#  define ICE_IO_URING @ICE_IO_URING@
+#else
+#  define ICE_IO_URING 0
+#endif
+
 namespace ice {
 
 constexpr inline std::size_t native_event_size = @native_event_size@;
@@ -3,14 +3,69 @@
 #include <ice/error.h>
 #include <ice/event.h>
 #include <ice/handle.h>
+#include <ice/result.h>
 #include <ice/utility.h>
+#include <array>
 #include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
 #include <cstdint>
 #include <cstddef>
 
 namespace ice {
+namespace detail {
+
+#if ICE_IO_URING
+class ring;
+#elif ICE_OS_LINUX
+class descriptor_table;
+#endif
+
+class wheel;
+class counters;
+class channel;
+
+// Message sent to a context. The function is called with the data on a thread that runs the context.
+// The optional destroy function is called with the data instead when the context is destroyed before it received the
+// message.
+struct message {
+  void (*call)(void* data) noexcept = nullptr;
+  void (*destroy)(void* data) noexcept = nullptr;
+  void* data = nullptr;
+};
+
+// Entry of the context timer wheel.
+class timer {
+public:
+  // Called by a thread that runs the context after the timer expired. Timers that expire together are called one
+  // after the other, and operations whose timeouts are in the same batch wait for them in timeout::stop(). So this
+  // must not resume coroutines or do other unbounded work.
+  virtual void expire() noexcept = 0;
+
+protected:
+  ~timer() = default;
+
+private:
+  friend class wheel;
+
+  timer* prev_ = nullptr;
+  timer* next_ = nullptr;
+  std::uint64_t tick_ = 0;
+  std::uint32_t slot_ = 0;
+  bool armed_ = false;
+};
+
+}  // namespace detail
 
 class schedule;
+class sleep;
+class timeout;
+class transfer;
 
 class context {
 public:
@@ -26,11 +81,53 @@ public:
   using handle_type = ice::handle<int, -1, close_type>;
 #endif
   using handle_view = handle_type::view;
+  using clock = std::chrono::steady_clock;
 
   constexpr static std::uint32_t stop_requested_flag = 1;
   constexpr static std::uint32_t thread_count_increment = 2;
 
-  context();
+  // Number of queued events resumed before polling for completions.
+  constexpr static std::size_t queue_batch_size = 1024;
+
+  // Readiness notification modes of the epoll backend.
+  // Edge-triggered contexts remember which sockets were drained and suspend operations on them without trying.
+  enum class trigger {
+    level,
+    edge,
+  };
+
+  // Bounds of the adaptive event buffer. The buffer doubles when a poll fills it and halves after a number of polls
+  // in a row that used less than a quarter of it, so that busy threads need fewer polls and idle threads that share a
+  // context leave completions to others.
+  constexpr static std::size_t min_event_buffer_size = 16;
+  constexpr static std::size_t max_event_buffer_size = 4096;
+  constexpr static std::size_t event_buffer_shrink_delay = 64;
+
+  // Counters of a thread that runs this context.
+  struct counters {
+    // Number of polls for completions.
+    std::uint64_t waits = 0;
+
+    // Number of completions returned by all polls.
+    std::uint64_t events = 0;
+
+    // Number of polls that filled the event buffer.
+    std::uint64_t full = 0;
+
+    // Number of non-blocking polls without completions while spinning. Not included in the other counters.
+    std::uint64_t spins = 0;
+
+    // Number of polls by the number of returned completions: 0, 1, 2-3, 4-7, ... and max_event_buffer_size or more.
+    std::array<std::uint64_t, 14> histogram = {};
+
+    // Current size of the event buffer.
+    std::size_t event_buffer_size = 0;
+
+    // True while a thread runs this context with these counters.
+    bool running = false;
+  };
+
+  explicit context(trigger mode = trigger::level);
 
   context(context&& other) = delete;
   context& operator=(context&& other) = delete;
@@ -40,13 +137,74 @@ public:
 
   virtual ~context();
 
-  void run(std::size_t event_buffer_size = 1);
+  // Runs the context on the calling thread. The event buffer adapts to the number of completions per poll when the
+  // size is 0 and has a fixed size otherwise.
+  void run(std::size_t event_buffer_size = 0);
+
+  // Returns the counters of every thread that ran this context. Counters of stopped threads are reused.
+  std::vector<counters> statistics() const;
+
+  // Makes threads that run out of work poll for completions without blocking for up to the given duration before
+  // they block. Trades a processor for wakeup latency. Spinning is disabled when the duration is zero (the default).
+  void spin(clock::duration duration) noexcept {
+    spin_.store(duration.count(), std::memory_order_relaxed);
+  }
+
+  clock::duration spin() const noexcept {
+    return clock::duration(spin_.load(std::memory_order_relaxed));
+  }
+
+  // Resumes queued events, completions that are ready and expired timers without waiting.
+  // Lets foreign loops drive the context without a dedicated thread. Must not be called by a thread that runs this
+  // context. Returns the number of resumed events.
+  std::size_t poll();
+
+  // Like poll(), but waits up to the given time for completions when no events are queued.
+  std::size_t run_one(clock::duration timeout);
+
+  // Returns how long a foreign loop may wait for the handle to become readable before it calls poll().
+  // Returns a negative duration when no timer is armed.
+  std::chrono::milliseconds poll_timeout() noexcept;
 
   void interrupt() noexcept;
   bool stop() noexcept;
 
   ice::schedule schedule(bool queue = false);
 
+  // Resumes the awaiting coroutine on a thread that runs this context. Continues on the current thread when it
+  // already runs this context. Unlike schedule(), each sending thread has its own queue and any number of transfers
+  // and posts between two polls of this context interrupt it at most once.
+  ice::transfer transfer() noexcept;
+
+  // Calls the function on a thread that runs this context. The function must not throw.
+  // Functions and transfers sent by the same thread are resumed in the order they were sent.
+  template <typename Function>
+  void post(Function&& function);
+
+  // Sends a message to a thread that runs this context. Returns false when memory could not be allocated or when the
+  // calling thread is exiting and already released its channels.
+  bool send(detail::message message) noexcept;
+
+  ice::sleep sleep_for(clock::duration duration) noexcept;
+  ice::sleep sleep_until(clock::time_point time) noexcept;
+
+  // Arms a timer that expires at the given time with millisecond resolution.
+  void arm(detail::timer& timer, clock::time_point time) noexcept;
+
+  // Disarms a timer. Returns false when the timer is not armed or already expired.
+  bool disarm(detail::timer& timer) noexcept;
+
+  // Queues an event to be resumed by a thread that runs this context.
+  // Only wakes up a waiting thread when the queue was empty and the caller does not run this context.
+  void queue(ice::event* ev) noexcept;
+
+#if !ICE_OS_WIN32
+  // Prepares a newly created file descriptor for waiting on this context.
+  void attach(int handle) noexcept;
+#endif
+
+  // The handle of the epoll, io_uring and kqueue backends becomes readable when completions are ready or events are
+  // queued and can be waited on by foreign loops. I/O completion ports can not be waited on.
   constexpr handle_type& handle() noexcept {
     return handle_;
   }
@@ -55,7 +213,7 @@ public:
     return handle_;
   }
 
-#if ICE_OS_LINUX
+#if ICE_OS_LINUX && !ICE_IO_URING
   constexpr handle_type& events() noexcept {
     return events_;
   }
@@ -63,6 +221,16 @@ public:
   constexpr const handle_type& events() const noexcept {
     return events_;
   }
+
+  detail::descriptor_table& descriptors() noexcept {
+    return *descriptors_;
+  }
+#endif
+
+#if ICE_IO_URING
+  detail::ring& ring() noexcept {
+    return *ring_;
+  }
 #endif
 
   bool is_current() const noexcept {
@@ -70,25 +238,79 @@ public:
   }
 
 private:
+  std::size_t drain() noexcept;
+  std::size_t receive(std::size_t limit) noexcept;
+
+  // Removes the channel from the list of channels. The previous channel is nullptr when the channel was the head.
+  void unlink(detail::channel* prev, detail::channel* channel) noexcept;
+
+  bool queued() const noexcept {
+    return queue_.load(std::memory_order_relaxed) || signaled_.load(std::memory_order_relaxed);
+  }
+  int wait(void* entries, std::size_t size, int timeout, bool& interrupted, ice::error_code& ec) noexcept;
+
+  detail::counters& acquire();
+  void release(detail::counters& counters) noexcept;
+
   std::atomic_uint32_t state_ = 0;
+  std::atomic<clock::rep> spin_ = 0;
+  std::atomic<ice::event*> queue_ = nullptr;
+  std::atomic<detail::channel*> channels_ = nullptr;
+  std::atomic_bool signaled_ = false;
+  std::atomic_bool receiving_ = false;
+  ice::thread_local_storage sender_;
+  std::unique_ptr<detail::wheel> wheel_;
   ice::thread_local_storage index_;
+  mutable std::mutex counters_mutex_;
+  std::vector<std::unique_ptr<detail::counters>> counters_;
   handle_type handle_;
-#if ICE_OS_LINUX
+#if ICE_OS_LINUX && !ICE_IO_URING
   handle_type events_;
+  std::unique_ptr<detail::descriptor_table> descriptors_;
+#endif
+#if ICE_IO_URING
+  std::unique_ptr<detail::ring> ring_;
 #endif
 };
 
 class schedule final : public ice::event {
 public:
-#if ICE_OS_LINUX
-  schedule(ice::context& context, bool queue) noexcept :
-    context_(context.handle()), handle_(context.events()), ready_(!queue && context.is_current()) {
+  schedule(ice::context& context, bool queue) noexcept : context_(context), ready_(!queue && context.is_current()) {
   }
-#else
-  schedule(ice::context& context, bool queue) noexcept :
-    context_(context.handle()), ready_(!queue && context.is_current()) {
+
+  constexpr bool await_ready() const noexcept {
+    return ready_;
+  }
+
+  bool suspend() noexcept override;
+
+  bool resume() noexcept override {
+    return true;
+  }
+
+  ice::nothrow_operation<schedule> nothrow() noexcept {
+    return ice::nothrow_operation<schedule>{ *this };
+  }
+
+  ice::result<void> result() noexcept {
+    return ec_;
+  }
+
+  void await_resume() {
+    if (const auto ec = result().error()) {
+      throw ice::system_error(ec, "schedule");
+    }
+  }
+
+private:
+  ice::context& context_;
+  const bool ready_;
+};
+
+class transfer final : public ice::event {
+public:
+  explicit transfer(ice::context& context) noexcept : context_(context), ready_(context.is_current()) {
   }
-#endif
 
   constexpr bool await_ready() const noexcept {
     return ready_;
@@ -100,22 +322,131 @@ public:
     return true;
   }
 
+  ice::nothrow_operation<transfer> nothrow() noexcept {
+    return ice::nothrow_operation<transfer>{ *this };
+  }
+
+  ice::result<void> result() noexcept {
+    return ec_;
+  }
+
   void await_resume() {
-    if (ec_) {
-      throw ice::system_error(ec_, "schedule");
+    if (const auto ec = result().error()) {
+      throw ice::system_error(ec, "transfer");
     }
   }
 
 private:
-  context::handle_view context_;
-#if ICE_OS_LINUX
-  context::handle_view handle_;
-#endif
+  ice::context& context_;
   const bool ready_;
 };
 
+class sleep final : public ice::event, public detail::timer {
+public:
+  sleep(ice::context& context, ice::context::clock::time_point time) noexcept : context_(context), time_(time) {
+  }
+
+  bool await_ready() const noexcept {
+    return time_ <= ice::context::clock::now();
+  }
+
+  bool suspend() noexcept override {
+    context_.arm(*this, time_);
+    return true;
+  }
+
+  bool resume() noexcept override {
+    return true;
+  }
+
+  void expire() noexcept override {
+    context_.queue(this);
+  }
+
+  constexpr void await_resume() const noexcept {
+  }
+
+private:
+  ice::context& context_;
+  const ice::context::clock::time_point time_;
+};
+
+// Cancels an event with std::errc::timed_out when its operation is still pending at the deadline.
+// Operations start the timeout when they suspend and stop it before they complete.
+class timeout final : public detail::timer {
+public:
+  explicit timeout(ice::event& ev) noexcept : event_(ev) {
+  }
+
+  timeout(ice::event& ev, ice::context::clock::duration duration) noexcept :
+    event_(ev), time_(ice::context::clock::now() + duration), enabled_(true) {
+  }
+
+  constexpr bool enabled() const noexcept {
+    return enabled_;
+  }
+
+  // Arms the timer unless it is disabled or already armed.
+  void start(ice::context& context) noexcept {
+    if (enabled_ && !context_) {
+      context_ = &context;
+      context.arm(*this, time_);
+    }
+  }
+
+  // Disarms the timer or waits for the thread that expires it.
+  void stop() noexcept {
+    if (context_ && !context_->disarm(*this)) {
+      while (!expired_.load(std::memory_order_acquire)) {
+      }
+    }
+    context_ = nullptr;
+  }
+
+  void expire() noexcept override {
+    event_.cancel(std::errc::timed_out);
+    expired_.store(true, std::memory_order_release);
+  }
+
+private:
+  ice::event& event_;
+  ice::context* context_ = nullptr;
+  ice::context::clock::time_point time_;
+  std::atomic_bool expired_ = false;
+  const bool enabled_ = false;
+};
+
 inline ice::schedule context::schedule(bool queue) {
   return { *this, queue };
 }
 
+inline ice::transfer context::transfer() noexcept {
+  return ice::transfer{ *this };
+}
+
+template <typename Function>
+void context::post(Function&& function) {
+  using function_type = std::decay_t<Function>;
+  auto data = std::make_unique<function_type>(std::forward<Function>(function));
+  const auto call = [](void* data) noexcept {
+    const std::unique_ptr<function_type> function(static_cast<function_type*>(data));
+    (*function)();
+  };
+  const auto destroy = [](void* data) noexcept {
+    delete static_cast<function_type*>(data);
+  };
+  if (!send({ call, destroy, data.get() })) {
+    throw std::bad_alloc();
+  }
+  data.release();
+}
+
+inline ice::sleep context::sleep_for(clock::duration duration) noexcept {
+  return { *this, clock::now() + duration };
+}
+
+inline ice::sleep context::sleep_until(clock::time_point time) noexcept {
+  return { *this, time };
+}
+
 }  // namespace ice
@@ -2,10 +2,14 @@
 #include <ice/config.h>
 #include <ice/error.h>
 #include <experimental/coroutine>
+#include <atomic>
 #include <type_traits>
+#include <cstdint>
 
 #if ICE_OS_WIN32
 typedef struct _OVERLAPPED OVERLAPPED;
+#elif ICE_OS_LINUX && ICE_IO_URING
+struct io_uring_cqe;
 #elif ICE_OS_LINUX
 struct epoll_event;
 #elif ICE_OS_FREEBSD
@@ -13,9 +17,20 @@ struct kevent;
 #endif
 
 namespace ice {
+namespace detail {
+
+#if ICE_OS_LINUX && !ICE_IO_URING
+class descriptor;
+#endif
+
+}  // namespace detail
+
+class context;
 
 #if ICE_OS_WIN32
 using native_event = OVERLAPPED;
+#elif ICE_OS_LINUX && ICE_IO_URING
+using native_event = struct io_uring_cqe;
 #elif ICE_OS_LINUX
 using native_event = struct epoll_event;
 #elif ICE_OS_FREEBSD
@@ -52,10 +67,7 @@ public:
   }
 
   void await_resume() noexcept {
-#if ICE_OS_LINUX
-    remove();
-#endif
-    if (resume() || !suspend()) {
+    if (ec_ || resume() || !suspend()) {
       awaiter_.resume();
     }
   }
@@ -67,26 +79,115 @@ public:
     return ec_;
   }
 
+  // Completes the pending operation with the given error unless it completes otherwise first.
+  // Has no effect on operations that are not cancelable. Can be called from any thread as long as the event exists.
+  void cancel(ice::error_code ec) noexcept;
+
 protected:
   native_event* get() noexcept {
     return reinterpret_cast<native_event*>(static_cast<event_base*>(this));
   }
 
+#if ICE_OS_LINUX && !ICE_IO_URING
+  // Returns false when an edge-triggered context knows that the descriptor has no data to read or no space to write.
+  // Must be called before the operation is tried, so that queue_recv and queue_send do not miss notifications.
+  bool ready_recv(ice::context& context, int id) noexcept;
+  bool ready_send(ice::context& context, int id) noexcept;
+  bool ready_error(ice::context& context, int id) noexcept;
+
+  // Records that a short read emptied the descriptor.
+  void drained_recv(ice::context& context, int id) noexcept;
+#elif ICE_OS_LINUX || ICE_OS_FREEBSD
+  bool ready_recv(ice::context&, int) noexcept {
+    return true;
+  }
+
+  bool ready_send(ice::context&, int) noexcept {
+    return true;
+  }
+
+  bool ready_error(ice::context&, int) noexcept {
+    return true;
+  }
+
+  void drained_recv(ice::context&, int) noexcept {
+  }
+#endif
+
 #if ICE_OS_LINUX || ICE_OS_FREEBSD
-  bool queue_recv(int context, int id) noexcept;
-  bool queue_send(int context, int id) noexcept;
-  bool queue_note(int context, int id) noexcept;
+  bool queue_recv(ice::context& context, int id) noexcept;
+  bool queue_send(ice::context& context, int id) noexcept;
+#endif
+
+#if ICE_OS_LINUX
+  // Waits until the socket error queue can be read with MSG_ERRQUEUE.
+  bool queue_error(ice::context& context, int id) noexcept;
+#endif
+
+#if ICE_IO_URING
+  // Queues an io_uring operation with this event as user data.
+  // The arguments are stored in the submission queue entry fields of the same name.
+  bool queue(ice::context& context, std::uint8_t opcode, int fd, const void* addr, std::uint32_t len,
+    std::uint64_t off = 0, std::uint32_t flags = 0) noexcept;
 #endif
 
+  // Makes the operation cancelable. Must be called before the operation is started.
+  // Cancelable operations must call settle() before they complete.
+  void cancelable() noexcept {
+    cancelable_ = true;
+  }
+
+#if ICE_OS_WIN32
+  // Must bracket starting an overlapped operation on the handle. Cancels the started operation when cancel() was
+  // called before. Returns true when the event is cancelable.
+  bool enter(std::uintptr_t handle) noexcept;
+  void leave(bool cancelable) noexcept;
+#endif
+
+  // Waits for threads that still access the event after it was canceled or resumed.
+  void settle() const noexcept {
+    if (cancelable_) {
+      while (users_.load(std::memory_order_acquire)) {
+      }
+    }
+  }
+
   ice::error_code ec_;
 
 private:
-#if ICE_OS_LINUX
-  void remove() noexcept;
+  friend class context;
+  friend class pool;
+
+  ice::error_code reason() const noexcept {
+    return { reason_.load(), ice::combined };
+  }
+
+#if !ICE_OS_WIN32
+  // Publishes the context of a cancelable operation before it is queued. Returns true when the event is cancelable.
+  bool enter(ice::context& context) noexcept;
+
+  // Withdraws the queued operation when it was canceled before it was queued. Returns false when it is not queued.
+  bool leave(bool cancelable, bool queued) noexcept;
+
+  // Withdraws the queued operation. Returns true when the caller owns the event and must resume it.
+  bool withdraw(ice::context& context) noexcept;
+#endif
 
-  int native_context_ = -1;
-  int native_id_ = -1;
+  std::atomic<int> reason_ = 0;
+  std::atomic<int> users_ = 0;
+  bool cancelable_ = false;
+
+#if ICE_OS_WIN32
+  std::atomic<std::uintptr_t> native_handle_ = 0;
+#else
+  std::atomic<ice::context*> native_context_ = nullptr;
 #endif
+#if ICE_OS_LINUX && !ICE_IO_URING
+  detail::descriptor* native_descriptor_ = nullptr;
+  std::uint32_t native_state_ = 0;
+#endif
+
+  ice::event* next_ = nullptr;
 
   std::experimental::coroutine_handle<> awaiter_;
 };
@@ -0,0 +1,56 @@
+#pragma once
+#include <ice/config.h>
+#include <cstdint>
+#include <cstddef>
+
+namespace ice {
+
+// Allocator of coroutine frames.
+//
+// Released frames of up to max_size bytes are kept in free lists per size class and thread and reused by the next
+// frame of the same size class that is allocated on that thread. Larger frames and frames that do not fit into a full
+// free list go to the heap.
+class frame_allocator {
+public:
+  constexpr static std::size_t granularity = 64;
+  constexpr static std::size_t max_size = 2048;
+
+  // Maximum number of frames kept per size class and thread.
+  constexpr static std::size_t cache_size = 64;
+
+  // Counters of all threads that allocated or released frames.
+  struct counters {
+    // Number of allocated frames.
+    std::uint64_t allocations = 0;
+
+    // Number of allocations that reused a frame from a free list.
+    std::uint64_t reused = 0;
+
+    // Number of allocations that were too large for a size class.
+    std::uint64_t large = 0;
+
+    // Number of released frames.
+    std::uint64_t deallocations = 0;
+
+    // Number of frames that are currently kept in free lists.
+    std::uint64_t cached = 0;
+  };
+
+  static void* allocate(std::size_t size);
+  static void deallocate(void* data, std::size_t size) noexcept;
+
+  static counters statistics();
+};
+
+// Base class of promise types that allocates coroutine frames with the frame allocator.
+struct frame_allocated {
+  static void* operator new(std::size_t size) {
+    return ice::frame_allocator::allocate(size);
+  }
+
+  static void operator delete(void* data, std::size_t size) noexcept {
+    ice::frame_allocator::deallocate(data, size);
+  }
+};
+
+}  // namespace ice
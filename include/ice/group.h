@@ -0,0 +1,71 @@
+#pragma once
+#include <ice/config.h>
+#include <ice/context.h>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cstddef>
+
+namespace ice {
+
+// Group of contexts that are each run by one thread pinned to its own processor.
+//
+// Operations stay on the context they were started on, so sockets that are created on a context are only served by
+// its thread. Coroutines move to a sibling context with co_await group.schedule(index).
+class context_group {
+public:
+  // Creates one context per processor the process may run on when the size is 0.
+  explicit context_group(std::size_t size = 0, ice::context::trigger mode = ice::context::trigger::level);
+
+  context_group(context_group&& other) = delete;
+  context_group& operator=(context_group&& other) = delete;
+
+  context_group(const context_group& other) = delete;
+  context_group& operator=(const context_group& other) = delete;
+
+  // Stops the contexts and waits for their threads.
+  ~context_group();
+
+  std::size_t size() const noexcept {
+    return contexts_.size();
+  }
+
+  ice::context& operator[](std::size_t index) noexcept {
+    return *contexts_[index];
+  }
+
+  const ice::context& operator[](std::size_t index) const noexcept {
+    return *contexts_[index];
+  }
+
+  // Returns the context run by the calling thread or nullptr.
+  ice::context* current() noexcept;
+
+  // Returns the contexts in round-robin order for distributing work.
+  ice::context& next() noexcept;
+
+  // Resumes the awaiting coroutine on the context with the given index.
+  ice::schedule schedule(std::size_t index) {
+    return contexts_[index]->schedule(true);
+  }
+
+  // Starts one thread per context. Threads are pinned to the processors the process may run on in order.
+  void start(std::size_t event_buffer_size = 0);
+
+  // Requests all contexts to stop.
+  void stop() noexcept;
+
+  // Waits for the threads to exit and rethrows the first exception that stopped one of them.
+  void join();
+
+private:
+  std::vector<std::unique_ptr<ice::context>> contexts_;
+  std::vector<std::thread> threads_;
+  std::vector<std::exception_ptr> errors_;
+  std::vector<unsigned> processors_;
+  std::atomic_size_t next_ = 0;
+};
+
+}  // namespace ice
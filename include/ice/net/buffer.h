@@ -15,6 +15,9 @@ struct basic_buffer {
 #endif
   using data_type = T*;
 
+  // Buffers have the layout of WSABUF on Windows and of iovec elsewhere, so that arrays of buffers can be passed to
+  // vectored operations as is.
+#if ICE_OS_WIN32
   constexpr basic_buffer(T* data = nullptr, std::size_t size = 0) noexcept :
     size(static_cast<size_type>(size)), data(data) {
     assert(size <= std::numeric_limits<size_type>::max());
@@ -23,6 +26,14 @@ struct basic_buffer {
 
   size_type size;
   data_type data;
+#else
+  constexpr basic_buffer(T* data = nullptr, std::size_t size = 0) noexcept : data(data), size(size) {
+    assert(size == 0 || data != nullptr);
+  }
+
+  data_type data;
+  size_type size;
+#endif
 };
 
 using buffer = basic_buffer<char>;
@@ -21,6 +21,8 @@ public:
   class recv_low_watermark;
   class send_low_watermark;
   class reuse_address;
+  class reuse_port;
+  class busy_poll;
 
   virtual ~option() = default;
 
@@ -193,4 +195,26 @@ public:
   int name() const noexcept override;
 };
 
+// Lets sockets bind to the same endpoint and distributes incoming connections between them (not supported on Windows).
+class option::reuse_port : public option_value<bool> {
+public:
+  using option_value::option_value;
+  int name() const noexcept override;
+};
+
+// Busy-polls the device queue for up to the given time when a receive or a poll finds no data (Linux only).
+// Raising the value above net.core.busy_read requires CAP_NET_ADMIN.
+class option::busy_poll : public option_value<std::size_t> {
+public:
+  busy_poll(std::chrono::microseconds duration = {}) noexcept :
+    option_value(duration.count() > 0 ? static_cast<std::size_t>(duration.count()) : 0) {
+  }
+
+  std::chrono::microseconds get() const noexcept {
+    return std::chrono::microseconds(option_value::get());
+  }
+
+  int name() const noexcept override;
+};
+
 }  // namespace ice::net
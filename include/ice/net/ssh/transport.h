@@ -21,10 +21,10 @@ public:
 
 #if ICE_OS_WIN32
   transport(net::tcp::socket& socket) noexcept :
-    context_(socket.context().handle()), socket_(socket.handle()), buffer_(storage_.data(), storage_.size()) {
+    context_(socket.context()), socket_(socket.handle()), buffer_(storage_.data(), storage_.size()) {
   }
 #else
-  transport(net::tcp::socket& socket) noexcept : context_(socket.context().handle()), socket_(socket.handle()) {
+  transport(net::tcp::socket& socket) noexcept : context_(socket.context()), socket_(socket.handle()) {
   }
 #endif
 
@@ -46,7 +46,7 @@ public:
 
 private:
   operation operation_ = operation::none;
-  ice::context::handle_view context_;
+  ice::context& context_;
   net::socket::handle_view socket_;
 #if ICE_OS_WIN32
   std::array<char, 4096> storage_;
@@ -0,0 +1,71 @@
+#pragma once
+#include <ice/async.h>
+#include <ice/net/tcp/socket.h>
+#include <memory>
+#include <string_view>
+#include <cstddef>
+
+namespace ice::net {
+
+// Buffered reader over a TCP socket.
+//
+// Reads complete with views into the internal buffer and consume the data they return. Views stay valid until the
+// next read, which may move the unconsumed data to the front of the buffer or into a larger one. The data is only
+// moved when the free space behind it cannot hold what the read needs, and the buffer only grows when the unconsumed
+// data does not fit at all. Reads that need more than the size limit fail with std::errc::message_size.
+//
+// Like tcp::recv, reads report connection resets as EOF and throw other receive errors as ice::system_error.
+class stream {
+public:
+  constexpr static std::size_t default_capacity = 16 * 1024;
+  constexpr static std::size_t default_limit = 1024 * 1024;
+
+  explicit stream(tcp::socket& socket, std::size_t capacity = default_capacity, std::size_t limit = default_limit);
+
+  stream(stream&& other) = delete;
+  stream& operator=(stream&& other) = delete;
+
+  stream(const stream& other) = delete;
+  stream& operator=(const stream& other) = delete;
+
+  tcp::socket& socket() noexcept {
+    return socket_;
+  }
+
+  // Returns the data that was received and not consumed yet.
+  std::string_view buffered() const noexcept {
+    return { data_.get() + begin_, end_ - begin_ };
+  }
+
+  // Completes with the buffered data and receives once when no data is buffered. Completes empty at EOF.
+  ice::async<std::string_view> read_some();
+
+  // Completes with the given number of bytes. Completes with fewer bytes only at EOF.
+  ice::async<std::string_view> read_exact(std::size_t size);
+
+  // Completes with the data up to and including the first occurrence of the delimiter. Completes with the remaining
+  // data without the delimiter at EOF. The delimiter must stay valid until the read completes.
+  ice::async<std::string_view> read_until(std::string_view delimiter);
+
+private:
+  // Makes room for receiving more data, so that the given number of unconsumed bytes fits into the buffer.
+  void reserve(std::size_t size);
+
+  // Receives into the free space of the buffer.
+  tcp::recv recv() noexcept;
+
+  // Appends the received data to the buffered data. Returns false at EOF.
+  bool commit(std::size_t size) noexcept;
+
+  // Consumes and returns the given number of buffered bytes.
+  std::string_view take(std::size_t size) noexcept;
+
+  tcp::socket& socket_;
+  std::unique_ptr<char[]> data_;
+  std::size_t capacity_;
+  const std::size_t limit_;
+  std::size_t begin_ = 0;
+  std::size_t end_ = 0;
+};
+
+}  // namespace ice::net
@@ -0,0 +1,17 @@
+#pragma once
+#include <ice/async.h>
+#include <ice/net/tcp/socket.h>
+#include <cstddef>
+
+namespace ice::net::tcp {
+
+// Relays data from one socket to the other until the first one reaches EOF and shuts down sending on the other one.
+// Completes with the number of bytes relayed. Relays in both directions await two pumps:
+//
+//   co_await ice::when_all(tcp::pump(client, server), tcp::pump(server, client));
+//
+// On Linux the data is moved through a pipe with splice and never copied to user space. Elsewhere, or when no pipe
+// can be created, it is copied through a buffer that is returned to a pool for later pumps.
+ice::async<std::size_t> pump(tcp::socket& from, tcp::socket& to);
+
+}  // namespace ice::net::tcp
@@ -1,12 +1,18 @@
 #pragma once
 #include <ice/config.h>
+#include <ice/async.h>
+#include <ice/cancel.h>
 #include <ice/context.h>
 #include <ice/error.h>
 #include <ice/event.h>
+#include <ice/group.h>
 #include <ice/net/buffer.h>
 #include <ice/net/socket.h>
+#include <ice/result.h>
 #include <utility>
+#include <vector>
 #include <cstddef>
+#include <cstdint>
 
 namespace ice::net::tcp {
 
@@ -15,6 +21,14 @@ class connect;
 class recv;
 class send;
 class send_some;
+class recv_buffers;
+class send_buffers;
+#if !ICE_OS_WIN32
+class send_file;
+#endif
+#if ICE_OS_LINUX
+class send_zerocopy;
+#endif
 
 class socket : public net::socket {
 public:
@@ -31,18 +45,101 @@ public:
   tcp::recv recv(char* data, std::size_t size);
   tcp::send send(const char* data, std::size_t size);
   tcp::send_some send_some(const char* data, std::size_t size);
+
+  // Operations that fail with std::errc::timed_out when they do not complete within the given duration.
+  tcp::accept accept(ice::context::clock::duration timeout);
+  tcp::connect connect(const net::endpoint& endpoint, ice::context::clock::duration timeout);
+  tcp::recv recv(char* data, std::size_t size, ice::context::clock::duration timeout);
+  tcp::send send(const char* data, std::size_t size, ice::context::clock::duration timeout);
+  tcp::send_some send_some(const char* data, std::size_t size, ice::context::clock::duration timeout);
+
+  // Operations that fail with std::errc::operation_canceled when the token is canceled before they complete.
+  tcp::accept accept(ice::cancellation_token token);
+  tcp::connect connect(const net::endpoint& endpoint, ice::cancellation_token token);
+  tcp::recv recv(char* data, std::size_t size, ice::cancellation_token token);
+  tcp::send send(const char* data, std::size_t size, ice::cancellation_token token);
+  tcp::send_some send_some(const char* data, std::size_t size, ice::cancellation_token token);
+
+  // Vectored operations. Receiving fills the buffers in order with the data of a single read. Sending writes all
+  // buffers with as few system calls as possible and advances the buffers past the data that was sent.
+  tcp::recv_buffers recv(const net::buffer* buffers, std::size_t count);
+  tcp::send_buffers send(net::const_buffer* buffers, std::size_t count);
+  tcp::recv_buffers recv(const net::buffer* buffers, std::size_t count, ice::context::clock::duration timeout);
+  tcp::send_buffers send(net::const_buffer* buffers, std::size_t count, ice::context::clock::duration timeout);
+  tcp::recv_buffers recv(const net::buffer* buffers, std::size_t count, ice::cancellation_token token);
+  tcp::send_buffers send(net::const_buffer* buffers, std::size_t count, ice::cancellation_token token);
+
+#if !ICE_OS_WIN32
+  // Sends the given range of a file with sendfile without copying it to user space. Completes with the number of bytes
+  // that were sent, which is less than the size when the file ends first.
+  tcp::send_file send_file(int file, std::uint64_t offset, std::size_t size);
+  tcp::send_file send_file(int file, std::uint64_t offset, std::size_t size, ice::context::clock::duration timeout);
+  tcp::send_file send_file(int file, std::uint64_t offset, std::size_t size, ice::cancellation_token token);
+#endif
+
+#if ICE_OS_LINUX
+  // Sends all data with MSG_ZEROCOPY and completes once the kernel released the pages, so that the data must stay
+  // valid and unchanged until then. This is why the operation cannot time out or be canceled. Only pays off for large
+  // blocks. Falls back to copying when the socket does not support SO_ZEROCOPY. Zero-copy sends on the same socket
+  // must not overlap, because each one waits for the completions of the send calls it made.
+  tcp::send_zerocopy send_zerocopy(const char* data, std::size_t size);
+
+private:
+  friend class tcp::send_zerocopy;
+
+  // Whether SO_ZEROCOPY was enabled on the socket. Set by the first zero-copy send.
+  enum class zerocopy : std::uint8_t {
+    unknown,
+    enabled,
+    unsupported,
+  };
+
+  zerocopy zerocopy_ = zerocopy::unknown;
+  bool zerocopy_pending_ = false;
+
+  // Identifier that the kernel assigns to the next send call with MSG_ZEROCOPY on the socket.
+  std::uint32_t zerocopy_id_ = 0;
+#endif
 };
 
+// Opens a listening socket on each context of the group. The sockets share the endpoint with SO_REUSEPORT, so that
+// the kernel distributes incoming connections between the contexts. Sockets are returned in context order.
+// Groups with more than one context are not supported on Windows, which cannot distribute connections this way.
+std::vector<tcp::socket> listen(ice::context_group& group, const net::endpoint& endpoint, std::size_t backlog = 0);
+
 class accept final : public ice::event {
 public:
 #if ICE_OS_WIN32
   accept(tcp::socket& socket) noexcept :
-    context_(socket.context().handle()), socket_(socket.handle()),
+    context_(socket.context()), socket_(socket.handle()),
     client_(socket.context(), socket.family(), socket.protocol()) {
   }
+
+  accept(tcp::socket& socket, ice::context::clock::duration timeout) noexcept :
+    context_(socket.context()), socket_(socket.handle()),
+    client_(socket.context(), socket.family(), socket.protocol()), timeout_(*this, timeout) {
+    cancelable();
+  }
+
+  accept(tcp::socket& socket, ice::cancellation_token token) noexcept :
+    context_(socket.context()), socket_(socket.handle()),
+    client_(socket.context(), socket.family(), socket.protocol()), registration_(*this, std::move(token)) {
+    cancelable();
+  }
 #else
   accept(tcp::socket& socket) noexcept :
-    context_(socket.context().handle()), socket_(socket.handle()), client_(socket.context()) {
+    context_(socket.context()), socket_(socket.handle()), client_(socket.context()) {
+  }
+
+  accept(tcp::socket& socket, ice::context::clock::duration timeout) noexcept :
+    context_(socket.context()), socket_(socket.handle()), client_(socket.context()), timeout_(*this, timeout) {
+    cancelable();
+  }
+
+  accept(tcp::socket& socket, ice::cancellation_token token) noexcept :
+    context_(socket.context()), socket_(socket.handle()), client_(socket.context()),
+    registration_(*this, std::move(token)) {
+    cancelable();
   }
 #endif
 
@@ -50,17 +147,34 @@ public:
   bool suspend() noexcept override;
   bool resume() noexcept override;
 
-  tcp::socket await_resume() {
+  ice::nothrow_operation<accept> nothrow() noexcept {
+    return ice::nothrow_operation<accept>{ *this };
+  }
+
+  ice::result<tcp::socket> result() noexcept {
+    timeout_.stop();
+    registration_.stop();
+    settle();
     if (ec_) {
-      throw ice::system_error(ec_, "accept tcp socket");
+      return ec_;
     }
     return std::move(client_);
   }
 
+  tcp::socket await_resume() {
+    auto client = result();
+    if (!client) {
+      throw ice::system_error(client.error(), "accept tcp socket");
+    }
+    return std::move(*client);
+  }
+
 private:
-  ice::context::handle_view context_;
+  ice::context& context_;
   net::socket::handle_view socket_;
   tcp::socket client_;
+  ice::timeout timeout_{ *this };
+  ice::cancellation_registration registration_{ *this };
 #if ICE_OS_WIN32
   constexpr static unsigned long buffer_size = sockaddr_storage_size + 16;
   char buffer_[buffer_size * 2];
@@ -71,44 +185,88 @@ private:
 class connect final : public ice::event {
 public:
   connect(tcp::socket& socket, const net::endpoint& endpoint) noexcept;
+  connect(tcp::socket& socket, const net::endpoint& endpoint, ice::context::clock::duration timeout) noexcept;
+  connect(tcp::socket& socket, const net::endpoint& endpoint, ice::cancellation_token token) noexcept;
 
   bool await_ready() noexcept;
   bool suspend() noexcept override;
   bool resume() noexcept override;
 
+  ice::nothrow_operation<connect> nothrow() noexcept {
+    return ice::nothrow_operation<connect>{ *this };
+  }
+
+  ice::result<void> result() noexcept {
+    timeout_.stop();
+    registration_.stop();
+    settle();
+    return ec_;
+  }
+
   void await_resume() {
-    if (ec_) {
-      throw ice::system_error(ec_, "connect");
+    if (const auto ec = result().error()) {
+      throw ice::system_error(ec, "connect");
     }
   }
 
 private:
-  ice::context::handle_view context_;
+  void prepare(tcp::socket& socket) noexcept;
+
+  ice::context& context_;
   net::socket::handle_view socket_;
   const net::endpoint endpoint_;
+  ice::timeout timeout_{ *this };
+  ice::cancellation_registration registration_{ *this };
 };
 
 class recv final : public ice::event {
 public:
   recv(tcp::socket& socket, char* data, std::size_t size) noexcept :
-    context_(socket.context().handle()), socket_(socket.handle()), buffer_(data, size) {
+    context_(socket.context()), socket_(socket.handle()), buffer_(data, size) {
+  }
+
+  recv(tcp::socket& socket, char* data, std::size_t size, ice::context::clock::duration timeout) noexcept :
+    context_(socket.context()), socket_(socket.handle()), buffer_(data, size), timeout_(*this, timeout) {
+    cancelable();
+  }
+
+  recv(tcp::socket& socket, char* data, std::size_t size, ice::cancellation_token token) noexcept :
+    context_(socket.context()), socket_(socket.handle()), buffer_(data, size), registration_(*this, std::move(token)) {
+    cancelable();
   }
 
   bool await_ready() noexcept;
   bool suspend() noexcept override;
   bool resume() noexcept override;
 
-  std::size_t await_resume() {
+  ice::nothrow_operation<recv> nothrow() noexcept {
+    return ice::nothrow_operation<recv>{ *this };
+  }
+
+  ice::result<std::size_t> result() noexcept {
+    timeout_.stop();
+    registration_.stop();
+    settle();
     if (ec_) {
-      throw ice::system_error(ec_, "tcp recv");
+      return ec_;
     }
     return static_cast<std::size_t>(buffer_.size);
   }
 
+  std::size_t await_resume() {
+    const auto size = result();
+    if (!size) {
+      throw ice::system_error(size.error(), "tcp recv");
+    }
+    return *size;
+  }
+
 private:
-  ice::context::handle_view context_;
+  ice::context& context_;
   net::socket::handle_view socket_;
   net::buffer buffer_;
+  ice::timeout timeout_{ *this };
+  ice::cancellation_registration registration_{ *this };
 #if ICE_OS_WIN32
   unsigned long bytes_ = 0;
   unsigned long flags_ = 0;
@@ -118,25 +276,52 @@ private:
 class send final : public ice::event {
 public:
   send(tcp::socket& socket, const char* data, std::size_t size) noexcept :
-    context_(socket.context().handle()), socket_(socket.handle()), buffer_(data, size) {
+    context_(socket.context()), socket_(socket.handle()), buffer_(data, size) {
+  }
+
+  send(tcp::socket& socket, const char* data, std::size_t size, ice::context::clock::duration timeout) noexcept :
+    context_(socket.context()), socket_(socket.handle()), buffer_(data, size), timeout_(*this, timeout) {
+    cancelable();
+  }
+
+  send(tcp::socket& socket, const char* data, std::size_t size, ice::cancellation_token token) noexcept :
+    context_(socket.context()), socket_(socket.handle()), buffer_(data, size), registration_(*this, std::move(token)) {
+    cancelable();
   }
 
   bool await_ready() noexcept;
   bool suspend() noexcept override;
   bool resume() noexcept override;
 
-  std::size_t await_resume() {
+  ice::nothrow_operation<send> nothrow() noexcept {
+    return ice::nothrow_operation<send>{ *this };
+  }
+
+  ice::result<std::size_t> result() noexcept {
+    timeout_.stop();
+    registration_.stop();
+    settle();
     if (ec_) {
-      throw ice::system_error(ec_, "tcp send");
+      return ec_;
     }
     return size_;
   }
 
+  std::size_t await_resume() {
+    const auto size = result();
+    if (!size) {
+      throw ice::system_error(size.error(), "tcp send");
+    }
+    return *size;
+  }
+
 private:
-  ice::context::handle_view context_;
+  ice::context& context_;
   net::socket::handle_view socket_;
   net::const_buffer buffer_;
   std::size_t size_ = 0;
+  ice::timeout timeout_{ *this };
+  ice::cancellation_registration registration_{ *this };
 #if ICE_OS_WIN32
   unsigned long bytes_ = 0;
 #endif
@@ -145,30 +330,298 @@ private:
 class send_some final : public ice::event {
 public:
   send_some(tcp::socket& socket, const char* data, std::size_t size) noexcept :
-    context_(socket.context().handle()), socket_(socket.handle()), buffer_(data, size) {
+    context_(socket.context()), socket_(socket.handle()), buffer_(data, size) {
+  }
+
+  send_some(tcp::socket& socket, const char* data, std::size_t size, ice::context::clock::duration timeout) noexcept :
+    context_(socket.context()), socket_(socket.handle()), buffer_(data, size), timeout_(*this, timeout) {
+    cancelable();
+  }
+
+  send_some(tcp::socket& socket, const char* data, std::size_t size, ice::cancellation_token token) noexcept :
+    context_(socket.context()), socket_(socket.handle()), buffer_(data, size), registration_(*this, std::move(token)) {
+    cancelable();
   }
 
   bool await_ready() noexcept;
   bool suspend() noexcept override;
   bool resume() noexcept override;
 
-  std::size_t await_resume() {
+  ice::nothrow_operation<send_some> nothrow() noexcept {
+    return ice::nothrow_operation<send_some>{ *this };
+  }
+
+  ice::result<std::size_t> result() noexcept {
+    timeout_.stop();
+    registration_.stop();
+    settle();
     if (ec_) {
-      throw ice::system_error(ec_, "tcp send some");
+      return ec_;
     }
     return size_;
   }
 
+  std::size_t await_resume() {
+    const auto size = result();
+    if (!size) {
+      throw ice::system_error(size.error(), "tcp send some");
+    }
+    return *size;
+  }
+
 private:
-  ice::context::handle_view context_;
+  ice::context& context_;
   net::socket::handle_view socket_;
   net::const_buffer buffer_;
   std::size_t size_ = 0;
+  ice::timeout timeout_{ *this };
+  ice::cancellation_registration registration_{ *this };
+#if ICE_OS_WIN32
+  unsigned long bytes_ = 0;
+#endif
+};
+
+class recv_buffers final : public ice::event {
+public:
+  recv_buffers(tcp::socket& socket, const net::buffer* buffers, std::size_t count) noexcept :
+    context_(socket.context()), socket_(socket.handle()), buffers_(buffers), count_(count) {
+  }
+
+  recv_buffers(tcp::socket& socket, const net::buffer* buffers, std::size_t count,
+    ice::context::clock::duration timeout) noexcept :
+    context_(socket.context()), socket_(socket.handle()), buffers_(buffers), count_(count), timeout_(*this, timeout) {
+    cancelable();
+  }
+
+  recv_buffers(tcp::socket& socket, const net::buffer* buffers, std::size_t count,
+    ice::cancellation_token token) noexcept :
+    context_(socket.context()), socket_(socket.handle()), buffers_(buffers), count_(count),
+    registration_(*this, std::move(token)) {
+    cancelable();
+  }
+
+  bool await_ready() noexcept;
+  bool suspend() noexcept override;
+  bool resume() noexcept override;
+
+  ice::nothrow_operation<recv_buffers> nothrow() noexcept {
+    return ice::nothrow_operation<recv_buffers>{ *this };
+  }
+
+  ice::result<std::size_t> result() noexcept {
+    timeout_.stop();
+    registration_.stop();
+    settle();
+    if (ec_) {
+      return ec_;
+    }
+    return size_;
+  }
+
+  std::size_t await_resume() {
+    const auto size = result();
+    if (!size) {
+      throw ice::system_error(size.error(), "tcp recv buffers");
+    }
+    return *size;
+  }
+
+private:
+  ice::context& context_;
+  net::socket::handle_view socket_;
+  const net::buffer* buffers_;
+  std::size_t count_;
+  std::size_t size_ = 0;
+  ice::timeout timeout_{ *this };
+  ice::cancellation_registration registration_{ *this };
+#if ICE_OS_WIN32
+  unsigned long bytes_ = 0;
+  unsigned long flags_ = 0;
+#endif
+};
+
+class send_buffers final : public ice::event {
+public:
+  send_buffers(tcp::socket& socket, net::const_buffer* buffers, std::size_t count) noexcept :
+    context_(socket.context()), socket_(socket.handle()), buffers_(buffers), count_(count) {
+  }
+
+  send_buffers(tcp::socket& socket, net::const_buffer* buffers, std::size_t count,
+    ice::context::clock::duration timeout) noexcept :
+    context_(socket.context()), socket_(socket.handle()), buffers_(buffers), count_(count), timeout_(*this, timeout) {
+    cancelable();
+  }
+
+  send_buffers(tcp::socket& socket, net::const_buffer* buffers, std::size_t count,
+    ice::cancellation_token token) noexcept :
+    context_(socket.context()), socket_(socket.handle()), buffers_(buffers), count_(count),
+    registration_(*this, std::move(token)) {
+    cancelable();
+  }
+
+  bool await_ready() noexcept;
+  bool suspend() noexcept override;
+  bool resume() noexcept override;
+
+  ice::nothrow_operation<send_buffers> nothrow() noexcept {
+    return ice::nothrow_operation<send_buffers>{ *this };
+  }
+
+  ice::result<std::size_t> result() noexcept {
+    timeout_.stop();
+    registration_.stop();
+    settle();
+    if (ec_) {
+      return ec_;
+    }
+    return size_;
+  }
+
+  std::size_t await_resume() {
+    const auto size = result();
+    if (!size) {
+      throw ice::system_error(size.error(), "tcp send buffers");
+    }
+    return *size;
+  }
+
+private:
+  // Skips the buffers that were sent and advances the first buffer that was sent partially.
+  // Returns true when all buffers were sent.
+  bool advance(std::size_t size) noexcept;
+
+  ice::context& context_;
+  net::socket::handle_view socket_;
+  net::const_buffer* buffers_;
+  std::size_t count_;
+  std::size_t size_ = 0;
+  ice::timeout timeout_{ *this };
+  ice::cancellation_registration registration_{ *this };
 #if ICE_OS_WIN32
   unsigned long bytes_ = 0;
 #endif
 };
 
+#if !ICE_OS_WIN32
+
+class send_file final : public ice::event {
+public:
+  send_file(tcp::socket& socket, int file, std::uint64_t offset, std::size_t size) noexcept :
+    context_(socket.context()), socket_(socket.handle()), file_(file), offset_(offset), remaining_(size) {
+  }
+
+  send_file(tcp::socket& socket, int file, std::uint64_t offset, std::size_t size,
+    ice::context::clock::duration timeout) noexcept :
+    context_(socket.context()), socket_(socket.handle()), file_(file), offset_(offset), remaining_(size),
+    timeout_(*this, timeout) {
+    cancelable();
+  }
+
+  send_file(tcp::socket& socket, int file, std::uint64_t offset, std::size_t size,
+    ice::cancellation_token token) noexcept :
+    context_(socket.context()), socket_(socket.handle()), file_(file), offset_(offset), remaining_(size),
+    registration_(*this, std::move(token)) {
+    cancelable();
+  }
+
+  bool await_ready() noexcept;
+  bool suspend() noexcept override;
+  bool resume() noexcept override;
+
+  ice::nothrow_operation<send_file> nothrow() noexcept {
+    return ice::nothrow_operation<send_file>{ *this };
+  }
+
+  ice::result<std::size_t> result() noexcept {
+    timeout_.stop();
+    registration_.stop();
+    settle();
+    if (ec_) {
+      return ec_;
+    }
+    return size_;
+  }
+
+  std::size_t await_resume() {
+    const auto size = result();
+    if (!size) {
+      throw ice::system_error(size.error(), "tcp send file");
+    }
+    return *size;
+  }
+
+private:
+  ice::context& context_;
+  net::socket::handle_view socket_;
+  const int file_;
+  std::uint64_t offset_;
+  std::size_t remaining_;
+  std::size_t size_ = 0;
+  ice::timeout timeout_{ *this };
+  ice::cancellation_registration registration_{ *this };
+};
+
+#endif
+
+#if ICE_OS_LINUX
+
+class send_zerocopy final : public ice::event {
+public:
+  send_zerocopy(tcp::socket& socket, const char* data, std::size_t size) noexcept :
+    context_(socket.context()), socket_(socket), buffer_(data, size) {
+  }
+
+  bool await_ready() noexcept;
+  bool suspend() noexcept override;
+  bool resume() noexcept override;
+
+  ice::nothrow_operation<send_zerocopy> nothrow() noexcept {
+    return ice::nothrow_operation<send_zerocopy>{ *this };
+  }
+
+  ice::result<std::size_t> result() noexcept {
+    socket_.zerocopy_pending_ = false;
+    if (ec_) {
+      return ec_;
+    }
+    if (send_ec_) {
+      return send_ec_;
+    }
+    return size_;
+  }
+
+  std::size_t await_resume() {
+    const auto size = result();
+    if (!size) {
+      throw ice::system_error(size.error(), "tcp send zerocopy");
+    }
+    return *size;
+  }
+
+private:
+  // Sends the remaining data and then reads completion notifications from the socket error queue until the kernel
+  // released the pages of all send calls. Returns false when the operation must wait for the socket.
+  bool advance() noexcept;
+
+  // Reads the available completion notifications. Returns false when the error queue is empty.
+  bool release() noexcept;
+
+  ice::context& context_;
+  tcp::socket& socket_;
+  net::const_buffer buffer_;
+  std::size_t size_ = 0;
+  ice::error_code send_ec_;
+
+  // The send calls that used MSG_ZEROCOPY were assigned the identifiers from first_ to first_ + count_ - 1.
+  // The kernel released the pages of released_ of them.
+  std::uint32_t first_ = 0;
+  std::uint32_t count_ = 0;
+  std::uint32_t released_ = 0;
+  bool sent_ = false;
+};
+
+#endif
+
 inline tcp::accept socket::accept() {
   return { *this };
 }
@@ -189,4 +642,96 @@ inline tcp::send_some socket::send_some(const char* data, std::size_t size) {
   return { *this, data, size };
 }
 
+inline tcp::accept socket::accept(ice::cancellation_token token) {
+  return { *this, std::move(token) };
+}
+
+inline tcp::connect socket::connect(const net::endpoint& endpoint, ice::cancellation_token token) {
+  return { *this, endpoint, std::move(token) };
+}
+
+inline tcp::recv socket::recv(char* data, std::size_t size, ice::cancellation_token token) {
+  return { *this, data, size, std::move(token) };
+}
+
+inline tcp::send socket::send(const char* data, std::size_t size, ice::cancellation_token token) {
+  return { *this, data, size, std::move(token) };
+}
+
+inline tcp::send_some socket::send_some(const char* data, std::size_t size, ice::cancellation_token token) {
+  return { *this, data, size, std::move(token) };
+}
+
+inline tcp::accept socket::accept(ice::context::clock::duration timeout) {
+  return { *this, timeout };
+}
+
+inline tcp::connect socket::connect(const net::endpoint& endpoint, ice::context::clock::duration timeout) {
+  return { *this, endpoint, timeout };
+}
+
+inline tcp::recv socket::recv(char* data, std::size_t size, ice::context::clock::duration timeout) {
+  return { *this, data, size, timeout };
+}
+
+inline tcp::send socket::send(const char* data, std::size_t size, ice::context::clock::duration timeout) {
+  return { *this, data, size, timeout };
+}
+
+inline tcp::send_some socket::send_some(const char* data, std::size_t size, ice::context::clock::duration timeout) {
+  return { *this, data, size, timeout };
+}
+
+inline tcp::recv_buffers socket::recv(const net::buffer* buffers, std::size_t count) {
+  return { *this, buffers, count };
+}
+
+inline tcp::send_buffers socket::send(net::const_buffer* buffers, std::size_t count) {
+  return { *this, buffers, count };
+}
+
+inline tcp::recv_buffers socket::recv(
+  const net::buffer* buffers, std::size_t count, ice::context::clock::duration timeout) {
+  return { *this, buffers, count, timeout };
+}
+
+inline tcp::send_buffers socket::send(
+  net::const_buffer* buffers, std::size_t count, ice::context::clock::duration timeout) {
+  return { *this, buffers, count, timeout };
+}
+
+inline tcp::recv_buffers socket::recv(const net::buffer* buffers, std::size_t count, ice::cancellation_token token) {
+  return { *this, buffers, count, std::move(token) };
+}
+
+inline tcp::send_buffers socket::send(net::const_buffer* buffers, std::size_t count, ice::cancellation_token token) {
+  return { *this, buffers, count, std::move(token) };
+}
+
+#if !ICE_OS_WIN32
+
+inline tcp::send_file socket::send_file(int file, std::uint64_t offset, std::size_t size) {
+  return { *this, file, offset, size };
+}
+
+inline tcp::send_file socket::send_file(
+  int file, std::uint64_t offset, std::size_t size, ice::context::clock::duration timeout) {
+  return { *this, file, offset, size, timeout };
+}
+
+inline tcp::send_file socket::send_file(
+  int file, std::uint64_t offset, std::size_t size, ice::cancellation_token token) {
+  return { *this, file, offset, size, std::move(token) };
+}
+
+#endif
+
+#if ICE_OS_LINUX
+
+inline tcp::send_zerocopy socket::send_zerocopy(const char* data, std::size_t size) {
+  return { *this, data, size };
+}
+
+#endif
+
 }  // namespace ice::net::tcp
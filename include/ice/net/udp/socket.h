@@ -1,10 +1,13 @@
 #pragma once
 #include <ice/config.h>
+#include <ice/cancel.h>
 #include <ice/context.h>
 #include <ice/error.h>
 #include <ice/event.h>
 #include <ice/net/buffer.h>
 #include <ice/net/socket.h>
+#include <ice/result.h>
+#include <utility>
 #include <cstddef>
 
 // WARNING: Work in progress. Do not use!
@@ -27,31 +30,59 @@ public:
   udp::recv recv(net::endpoint& endpoint, char* data, std::size_t size);
   udp::send send(const net::endpoint& endpoint, const char* data, std::size_t size);
   udp::send_some send_some(const net::endpoint& endpoint, const char* data, std::size_t size);
+
+  // Operations that fail with std::errc::operation_canceled when the token is canceled before they complete.
+  udp::recv recv(net::endpoint& endpoint, char* data, std::size_t size, ice::cancellation_token token);
+  udp::send send(const net::endpoint& endpoint, const char* data, std::size_t size, ice::cancellation_token token);
+  udp::send_some send_some(const net::endpoint& endpoint, const char* data, std::size_t size,
+    ice::cancellation_token token);
 };
 
 class recv final : public ice::event {
 public:
   recv(udp::socket& socket, net::endpoint& endpoint, char* data, std::size_t size) noexcept :
-    context_(socket.context().handle()), socket_(socket.handle()), endpoint_(endpoint), buffer_(data, size) {
+    context_(socket.context()), socket_(socket.handle()), endpoint_(endpoint), buffer_(data, size) {
+  }
+
+  recv(udp::socket& socket, net::endpoint& endpoint, char* data, std::size_t size,
+    ice::cancellation_token token) noexcept :
+    context_(socket.context()), socket_(socket.handle()), endpoint_(endpoint), buffer_(data, size),
+    registration_(*this, std::move(token)) {
+    cancelable();
   }
 
   bool await_ready() noexcept;
   bool suspend() noexcept override;
   bool resume() noexcept override;
 
-  std::size_t await_resume() {
+  ice::nothrow_operation<recv> nothrow() noexcept {
+    return ice::nothrow_operation<recv>{ *this };
+  }
+
+  ice::result<std::size_t> result() noexcept {
+    registration_.stop();
+    settle();
     if (ec_) {
-      throw ice::system_error(ec_, "udp recv");
+      return ec_;
     }
     return size_;
   }
 
+  std::size_t await_resume() {
+    const auto size = result();
+    if (!size) {
+      throw ice::system_error(size.error(), "udp recv");
+    }
+    return *size;
+  }
+
 private:
-  ice::context::handle_view context_;
+  ice::context& context_;
   net::socket::handle_view socket_;
   net::endpoint& endpoint_;
   net::buffer buffer_;
   std::size_t size_ = 0;
+  ice::cancellation_registration registration_{ *this };
 #if ICE_OS_WIN32
   unsigned long bytes_ = 0;
   unsigned long flags_ = 0;
@@ -61,26 +92,48 @@ private:
 class send final : public ice::event {
 public:
   send(udp::socket& socket, const net::endpoint& endpoint, const char* data, std::size_t size) noexcept :
-    context_(socket.context().handle()), socket_(socket.handle()), endpoint_(endpoint), buffer_(data, size) {
+    context_(socket.context()), socket_(socket.handle()), endpoint_(endpoint), buffer_(data, size) {
+  }
+
+  send(udp::socket& socket, const net::endpoint& endpoint, const char* data, std::size_t size,
+    ice::cancellation_token token) noexcept :
+    context_(socket.context()), socket_(socket.handle()), endpoint_(endpoint), buffer_(data, size),
+    registration_(*this, std::move(token)) {
+    cancelable();
   }
 
   bool await_ready() noexcept;
   bool suspend() noexcept override;
   bool resume() noexcept override;
 
-  std::size_t await_resume() {
+  ice::nothrow_operation<send> nothrow() noexcept {
+    return ice::nothrow_operation<send>{ *this };
+  }
+
+  ice::result<std::size_t> result() noexcept {
+    registration_.stop();
+    settle();
     if (ec_) {
-      throw ice::system_error(ec_, "udp send");
+      return ec_;
     }
     return size_;
   }
 
+  std::size_t await_resume() {
+    const auto size = result();
+    if (!size) {
+      throw ice::system_error(size.error(), "udp send");
+    }
+    return *size;
+  }
+
 private:
-  ice::context::handle_view context_;
+  ice::context& context_;
   net::socket::handle_view socket_;
   const net::endpoint& endpoint_;
   net::const_buffer buffer_;
   std::size_t size_ = 0;
+  ice::cancellation_registration registration_{ *this };
 #if ICE_OS_WIN32
   unsigned long bytes_ = 0;
 #endif
@@ -89,26 +142,48 @@ private:
 class send_some final : public ice::event {
 public:
   send_some(udp::socket& socket, const net::endpoint& endpoint, const char* data, std::size_t size) noexcept :
-    context_(socket.context().handle()), socket_(socket.handle()), endpoint_(endpoint), buffer_(data, size) {
+    context_(socket.context()), socket_(socket.handle()), endpoint_(endpoint), buffer_(data, size) {
+  }
+
+  send_some(udp::socket& socket, const net::endpoint& endpoint, const char* data, std::size_t size,
+    ice::cancellation_token token) noexcept :
+    context_(socket.context()), socket_(socket.handle()), endpoint_(endpoint), buffer_(data, size),
+    registration_(*this, std::move(token)) {
+    cancelable();
   }
 
   bool await_ready() noexcept;
   bool suspend() noexcept override;
   bool resume() noexcept override;
 
-  std::size_t await_resume() {
+  ice::nothrow_operation<send_some> nothrow() noexcept {
+    return ice::nothrow_operation<send_some>{ *this };
+  }
+
+  ice::result<std::size_t> result() noexcept {
+    registration_.stop();
+    settle();
     if (ec_) {
-      throw ice::system_error(ec_, "udp send some");
+      return ec_;
     }
     return size_;
   }
 
+  std::size_t await_resume() {
+    const auto size = result();
+    if (!size) {
+      throw ice::system_error(size.error(), "udp send some");
+    }
+    return *size;
+  }
+
 private:
-  ice::context::handle_view context_;
+  ice::context& context_;
   net::socket::handle_view socket_;
   const net::endpoint& endpoint_;
   net::const_buffer buffer_;
   std::size_t size_ = 0;
+  ice::cancellation_registration registration_{ *this };
 #if ICE_OS_WIN32
   unsigned long bytes_ = 0;
 #endif
@@ -126,4 +201,18 @@ inline udp::send_some socket::send_some(const net::endpoint& endpoint, const cha
   return { *this, endpoint, data, size };
 }
 
+inline udp::recv socket::recv(net::endpoint& endpoint, char* data, std::size_t size, ice::cancellation_token token) {
+  return { *this, endpoint, data, size, std::move(token) };
+}
+
+inline udp::send socket::send(
+  const net::endpoint& endpoint, const char* data, std::size_t size, ice::cancellation_token token) {
+  return { *this, endpoint, data, size, std::move(token) };
+}
+
+inline udp::send_some socket::send_some(
+  const net::endpoint& endpoint, const char* data, std::size_t size, ice::cancellation_token token) {
+  return { *this, endpoint, data, size, std::move(token) };
+}
+
 }  // namespace ice::net::udp
@@ -0,0 +1,105 @@
+#pragma once
+#include <ice/config.h>
+#include <ice/event.h>
+#include <ice/utility.h>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <cstddef>
+
+namespace ice {
+namespace detail {
+
+class worker;
+
+}  // namespace detail
+
+class pool_schedule;
+
+// Work-stealing thread pool for CPU-bound coroutine work.
+//
+// Each worker owns a Chase-Lev deque. Events queued by a worker are pushed to its own deque and events queued by other
+// threads are pushed to a shared queue. Idle workers take work from their own deque, then from the shared queue and
+// then steal from random victims before they sleep.
+//
+// Coroutines move to the pool with co_await pool.schedule() and back to a context with co_await context.schedule().
+class pool {
+public:
+  // Number of steal attempts on random victims before a worker looks for work in every deque and sleeps.
+  constexpr static std::size_t steal_attempts = 64;
+
+  // Starts one worker per hardware thread when the size is 0.
+  explicit pool(std::size_t size = 0);
+
+  pool(pool&& other) = delete;
+  pool& operator=(pool&& other) = delete;
+
+  pool(const pool& other) = delete;
+  pool& operator=(const pool& other) = delete;
+
+  // Waits for the workers to run out of queued events and stops them.
+  ~pool();
+
+  std::size_t size() const noexcept {
+    return workers_.size();
+  }
+
+  ice::pool_schedule schedule() noexcept;
+
+  // Queues an event to be resumed by a worker.
+  void queue(ice::event* ev) noexcept;
+
+  bool is_current() const noexcept {
+    return index_.get() ? true : false;
+  }
+
+private:
+  void run(detail::worker& worker) noexcept;
+  ice::event* find(detail::worker& worker) noexcept;
+  ice::event* take() noexcept;
+  bool empty() const noexcept;
+  void notify() noexcept;
+
+  std::vector<std::unique_ptr<detail::worker>> workers_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  ice::event* head_ = nullptr;
+  ice::event* tail_ = nullptr;
+  std::atomic_size_t size_ = 0;
+  std::atomic_size_t sleeping_ = 0;
+  std::atomic_bool stop_ = false;
+  ice::thread_local_storage index_;
+};
+
+class pool_schedule final : public ice::event {
+public:
+  explicit pool_schedule(ice::pool& pool) noexcept : pool_(pool) {
+  }
+
+  constexpr bool await_ready() const noexcept {
+    return false;
+  }
+
+  bool suspend() noexcept override {
+    pool_.queue(this);
+    return true;
+  }
+
+  bool resume() noexcept override {
+    return true;
+  }
+
+  constexpr void await_resume() const noexcept {
+  }
+
+private:
+  ice::pool& pool_;
+};
+
+inline ice::pool_schedule pool::schedule() noexcept {
+  return ice::pool_schedule{ *this };
+}
+
+}  // namespace ice
@@ -0,0 +1,136 @@
+#pragma once
+#include <ice/error.h>
+#include <experimental/coroutine>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <cassert>
+
+namespace ice {
+
+// Value or error code of an operation that was awaited with nothrow().
+template <typename T>
+class result {
+public:
+  result(T value) noexcept(std::is_nothrow_move_constructible_v<T>) : value_(std::move(value)) {
+  }
+
+  result(ice::error_code ec) noexcept : ec_(ec) {
+    assert(ec);
+  }
+
+  constexpr explicit operator bool() const noexcept {
+    return !ec_;
+  }
+
+  constexpr bool has_value() const noexcept {
+    return !ec_;
+  }
+
+  constexpr ice::error_code error() const noexcept {
+    return ec_;
+  }
+
+  // Returns the value or throws ice::system_error.
+  T& value() & {
+    check();
+    return *value_;
+  }
+
+  const T& value() const& {
+    check();
+    return *value_;
+  }
+
+  T&& value() && {
+    check();
+    return std::move(*value_);
+  }
+
+  T& operator*() & noexcept {
+    return *value_;
+  }
+
+  const T& operator*() const& noexcept {
+    return *value_;
+  }
+
+  T&& operator*() && noexcept {
+    return std::move(*value_);
+  }
+
+  T* operator->() noexcept {
+    return &*value_;
+  }
+
+  const T* operator->() const noexcept {
+    return &*value_;
+  }
+
+private:
+  void check() const {
+    if (ec_) {
+      throw ice::system_error(ec_);
+    }
+  }
+
+  std::optional<T> value_;
+  ice::error_code ec_;
+};
+
+template <>
+class result<void> {
+public:
+  constexpr result() noexcept = default;
+
+  constexpr result(ice::error_code ec) noexcept : ec_(ec) {
+  }
+
+  constexpr explicit operator bool() const noexcept {
+    return !ec_;
+  }
+
+  constexpr bool has_value() const noexcept {
+    return !ec_;
+  }
+
+  constexpr ice::error_code error() const noexcept {
+    return ec_;
+  }
+
+  // Throws ice::system_error on failure.
+  void value() const {
+    if (ec_) {
+      throw ice::system_error(ec_);
+    }
+  }
+
+private:
+  ice::error_code ec_;
+};
+
+// Awaits an operation and returns its result instead of throwing.
+// Operations provide it with nothrow() and complete it with a noexcept result() member function.
+template <typename Operation>
+class nothrow_operation {
+public:
+  explicit nothrow_operation(Operation& operation) noexcept : operation_(operation) {
+  }
+
+  bool await_ready() noexcept {
+    return operation_.await_ready();
+  }
+
+  bool await_suspend(std::experimental::coroutine_handle<> awaiter) noexcept {
+    return operation_.await_suspend(awaiter);
+  }
+
+  auto await_resume() noexcept {
+    return operation_.result();
+  }
+
+private:
+  Operation& operation_;
+};
+
+}  // namespace ice
@@ -0,0 +1,252 @@
+#pragma once
+#include <ice/async.h>
+#include <ice/cancel.h>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <cstddef>
+
+namespace ice {
+
+// Index and result of the coroutine that completed first in when_any.
+template <typename T>
+struct when_any_result {
+  std::size_t index = 0;
+  T value;
+};
+
+template <>
+struct when_any_result<void> {
+  std::size_t index = 0;
+};
+
+namespace detail {
+
+// Result of a void coroutine in the tuple returned by when_all.
+struct void_value {};
+
+template <typename T>
+using when_all_value_t = std::conditional_t<std::is_void_v<T>, detail::void_value, T>;
+
+template <typename T>
+using when_all_element_t =
+  std::conditional_t<std::is_reference_v<T>, std::reference_wrapper<std::remove_reference_t<T>>, T>;
+
+// Counts down the coroutines started by when_all and when_any and resumes the awaiting coroutine after the last one
+// completed. The awaiting coroutine holds one count, so that it can not be resumed before it suspended.
+class when_counter {
+public:
+  explicit when_counter(std::size_t count) noexcept : count_(count + 1) {
+  }
+
+  // Returns false when all coroutines completed before the awaiting coroutine suspended.
+  bool suspend(std::experimental::coroutine_handle<> awaiter) noexcept {
+    awaiter_ = awaiter;
+    return count_.fetch_sub(1, std::memory_order_acq_rel) > 1;
+  }
+
+  void notify() noexcept {
+    if (count_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      awaiter_.resume();
+    }
+  }
+
+  detail::continuation continuation() noexcept {
+    return detail::continuation{ [](void* state) { static_cast<when_counter*>(state)->notify(); }, this };
+  }
+
+private:
+  std::atomic<std::size_t> count_;
+  std::experimental::coroutine_handle<> awaiter_;
+};
+
+template <typename T>
+detail::when_all_value_t<T> when_all_result(ice::async<T>& task) {
+  if constexpr (std::is_void_v<T>) {
+    task.result();
+    return {};
+  } else {
+    return std::move(task).result();
+  }
+}
+
+template <typename... T>
+class when_all_awaitable {
+public:
+  explicit when_all_awaitable(ice::async<T>... tasks) noexcept : tasks_(std::move(tasks)...) {
+  }
+
+  constexpr bool await_ready() const noexcept {
+    return sizeof...(T) == 0;
+  }
+
+  bool await_suspend(std::experimental::coroutine_handle<> awaiter) noexcept {
+    std::apply([this](auto&... tasks) { (tasks.get_starter().start(counter_.continuation()), ...); }, tasks_);
+    return counter_.suspend(awaiter);
+  }
+
+  // Rethrows the first exception in argument order.
+  std::tuple<detail::when_all_value_t<T>...> await_resume() {
+    return std::apply(
+      [](auto&... tasks) { return std::tuple<detail::when_all_value_t<T>...>{ detail::when_all_result(tasks)... }; },
+      tasks_);
+  }
+
+private:
+  std::tuple<ice::async<T>...> tasks_;
+  detail::when_counter counter_{ sizeof...(T) };
+};
+
+template <typename T>
+class when_all_vector_awaitable {
+public:
+  explicit when_all_vector_awaitable(std::vector<ice::async<T>> tasks) noexcept :
+    tasks_(std::move(tasks)), counter_(tasks_.size()) {
+  }
+
+  bool await_ready() const noexcept {
+    return tasks_.empty();
+  }
+
+  bool await_suspend(std::experimental::coroutine_handle<> awaiter) noexcept {
+    for (auto& task : tasks_) {
+      task.get_starter().start(counter_.continuation());
+    }
+    return counter_.suspend(awaiter);
+  }
+
+  // Rethrows the first exception in vector order.
+  auto await_resume() {
+    if constexpr (std::is_void_v<T>) {
+      for (auto& task : tasks_) {
+        task.result();
+      }
+    } else {
+      std::vector<detail::when_all_element_t<T>> result;
+      result.reserve(tasks_.size());
+      for (auto& task : tasks_) {
+        result.emplace_back(std::move(task).result());
+      }
+      return result;
+    }
+  }
+
+private:
+  std::vector<ice::async<T>> tasks_;
+  detail::when_counter counter_;
+};
+
+// Completion callback of a coroutine started by when_any.
+template <typename State>
+struct when_any_entry {
+  State* state = nullptr;
+  std::size_t index = 0;
+};
+
+template <typename Tasks, typename Entry>
+struct when_any_entries {
+  using type = std::vector<Entry>;
+};
+
+template <typename Task, std::size_t Size, typename Entry>
+struct when_any_entries<std::array<Task, Size>, Entry> {
+  using type = std::array<Entry, Size>;
+};
+
+template <typename T, typename Tasks>
+class when_any_awaitable {
+public:
+  constexpr static std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+  when_any_awaitable(ice::cancellation_source& source, Tasks tasks) :
+    source_(source), tasks_(std::move(tasks)), counter_(tasks_.size()) {
+    if constexpr (std::is_same_v<Tasks, std::vector<ice::async<T>>>) {
+      entries_.resize(tasks_.size());
+    }
+  }
+
+  bool await_ready() const noexcept {
+    return tasks_.empty();
+  }
+
+  bool await_suspend(std::experimental::coroutine_handle<> awaiter) noexcept {
+    const auto callback = [](void* state) {
+      const auto entry = static_cast<when_any_entry<when_any_awaitable>*>(state);
+      entry->state->complete(entry->index);
+    };
+    for (std::size_t i = 0; i < tasks_.size(); i++) {
+      entries_[i] = { this, i };
+      tasks_[i].get_starter().start(detail::continuation{ callback, &entries_[i] });
+    }
+    return counter_.suspend(awaiter);
+  }
+
+  // Returns the index and the result of the coroutine that completed first or rethrows its exception.
+  auto await_resume() {
+    const auto index = winner_.load(std::memory_order_relaxed);
+    if (index == npos) {
+      throw ice::broken_promise{};
+    }
+    if constexpr (std::is_void_v<T>) {
+      tasks_[index].result();
+      return ice::when_any_result<void>{ index };
+    } else {
+      return ice::when_any_result<T>{ index, std::move(tasks_[index]).result() };
+    }
+  }
+
+private:
+  void complete(std::size_t index) noexcept {
+    auto expected = npos;
+    if (winner_.compare_exchange_strong(expected, index, std::memory_order_relaxed)) {
+      source_.cancel();
+    }
+    counter_.notify();
+  }
+
+  ice::cancellation_source& source_;
+  Tasks tasks_;
+  typename when_any_entries<Tasks, when_any_entry<when_any_awaitable>>::type entries_ = {};
+  std::atomic<std::size_t> winner_ = npos;
+  detail::when_counter counter_;
+};
+
+}  // namespace detail
+
+// Starts the coroutines on the current thread and waits until all of them completed.
+// The result is a tuple of the coroutine results with detail::void_value for void coroutines. The first exception in
+// argument order is rethrown after all coroutines completed.
+template <typename... T>
+[[nodiscard]] detail::when_all_awaitable<T...> when_all(ice::async<T>... tasks) {
+  return detail::when_all_awaitable<T...>{ std::move(tasks)... };
+}
+
+// Starts the coroutines on the current thread and waits until all of them completed.
+// The result is a vector of the coroutine results in the same order or void for void coroutines.
+template <typename T>
+[[nodiscard]] detail::when_all_vector_awaitable<T> when_all(std::vector<ice::async<T>> tasks) {
+  return detail::when_all_vector_awaitable<T>{ std::move(tasks) };
+}
+
+// Starts the coroutines on the current thread and cancels the source when the first of them completed.
+// Coroutines that lose must use tokens of the source for their operations. The awaiting coroutine is resumed after all
+// coroutines completed and gets the index and the result of the first one. Exceptions of the others are ignored.
+template <typename T, typename... U>
+[[nodiscard]] auto when_any(ice::cancellation_source& source, ice::async<T> task, ice::async<U>... tasks) {
+  static_assert((std::is_same_v<T, U> && ...), "when_any coroutines must have the same result type");
+  using tasks_type = std::array<ice::async<T>, sizeof...(U) + 1>;
+  return detail::when_any_awaitable<T, tasks_type>{ source, tasks_type{ std::move(task), std::move(tasks)... } };
+}
+
+template <typename T>
+[[nodiscard]] auto when_any(ice::cancellation_source& source, std::vector<ice::async<T>> tasks) {
+  using tasks_type = std::vector<ice::async<T>>;
+  return detail::when_any_awaitable<T, tasks_type>{ source, std::move(tasks) };
+}
+
+}  // namespace ice
@@ -18,6 +18,9 @@
 
 #if defined(WIN32)
 struct native_event : OVERLAPPED {};
+#elif defined(__linux__) && ICE_IO_URING
+#include <linux/io_uring.h>
+struct native_event : io_uring_cqe {};
 #elif defined(__linux__)
 #include <sys/epoll.h>
 struct native_event : epoll_event {};
@@ -0,0 +1,104 @@
+#include <ice/cancel.h>
+#include <mutex>
+
+namespace ice {
+namespace detail {
+
+// Shared state of a cancellation source and its tokens with the list of registered operations.
+class cancellation_state {
+public:
+  bool canceled() const noexcept {
+    return canceled_.load(std::memory_order_acquire);
+  }
+
+  bool cancel() noexcept {
+    std::unique_lock lock(mutex_);
+    if (canceled_.load(std::memory_order_relaxed)) {
+      return false;
+    }
+    canceled_.store(true, std::memory_order_release);
+    // Events are canceled outside the lock, so that a concurrent completion does not wait for other events.
+    while (const auto entry = head_) {
+      unlink(*entry);
+      lock.unlock();
+      entry->event_.cancel(std::errc::operation_canceled);
+      entry->canceled_.store(true, std::memory_order_release);
+      lock.lock();
+    }
+    return true;
+  }
+
+  void add(cancellation_registration& entry) noexcept {
+    std::unique_lock lock(mutex_);
+    if (canceled_.load(std::memory_order_relaxed)) {
+      lock.unlock();
+      entry.event_.cancel(std::errc::operation_canceled);
+      entry.canceled_.store(true, std::memory_order_relaxed);
+      return;
+    }
+    entry.prev_ = nullptr;
+    entry.next_ = head_;
+    if (head_) {
+      head_->prev_ = &entry;
+    }
+    head_ = &entry;
+    entry.linked_ = true;
+    entry.canceled_.store(false, std::memory_order_relaxed);
+  }
+
+  void remove(cancellation_registration& entry) noexcept {
+    std::unique_lock lock(mutex_);
+    if (entry.linked_) {
+      unlink(entry);
+      return;
+    }
+    lock.unlock();
+    // The entry was taken by a thread that cancels it.
+    while (!entry.canceled_.load(std::memory_order_acquire)) {
+    }
+  }
+
+private:
+  void unlink(cancellation_registration& entry) noexcept {
+    if (entry.prev_) {
+      entry.prev_->next_ = entry.next_;
+    } else {
+      head_ = entry.next_;
+    }
+    if (entry.next_) {
+      entry.next_->prev_ = entry.prev_;
+    }
+    entry.linked_ = false;
+  }
+
+  std::mutex mutex_;
+  std::atomic_bool canceled_ = false;
+  cancellation_registration* head_ = nullptr;
+};
+
+}  // namespace detail
+
+bool cancellation_token::is_canceled() const noexcept {
+  return state_ && state_->canceled();
+}
+
+cancellation_source::cancellation_source() : state_(std::make_shared<detail::cancellation_state>()) {
+}
+
+bool cancellation_source::cancel() noexcept {
+  return state_->cancel();
+}
+
+bool cancellation_source::is_canceled() const noexcept {
+  return state_->canceled();
+}
+
+void cancellation_registration::add() noexcept {
+  state_->add(*this);
+}
+
+void cancellation_registration::remove() noexcept {
+  state_->remove(*this);
+}
+
+}  // namespace ice
@@ -0,0 +1,64 @@
+#include "channel.h"
+#include <new>
+#include <utility>
+
+namespace ice::detail {
+
+channel::~channel() {
+  for (auto entry = read_; entry;) {
+    delete std::exchange(entry, entry->next.load(std::memory_order_relaxed));
+  }
+  delete spare_.load(std::memory_order_relaxed);
+}
+
+bool channel::reserve() noexcept {
+  write_ = allocate();
+  read_ = write_;
+  return write_ != nullptr;
+}
+
+bool channel::push(const detail::message& message) noexcept {
+  if (write_index_ == segment_size) {
+    const auto next = allocate();
+    if (!next) {
+      return false;
+    }
+    write_->next.store(next, std::memory_order_release);
+    write_ = next;
+    write_index_ = 0;
+  }
+  write_->entries[write_index_] = message;
+  write_->size.store(++write_index_, std::memory_order_release);
+  return true;
+}
+
+bool channel::pop(detail::message& message) noexcept {
+  while (true) {
+    if (read_index_ < read_->size.load(std::memory_order_acquire)) {
+      message = read_->entries[read_index_++];
+      return true;
+    }
+    if (read_index_ < segment_size) {
+      return false;
+    }
+    // The producer links the next segment after it filled this one and does not access this one afterwards.
+    const auto next = read_->next.load(std::memory_order_acquire);
+    if (!next) {
+      return false;
+    }
+    read_->size.store(0, std::memory_order_relaxed);
+    read_->next.store(nullptr, std::memory_order_relaxed);
+    delete spare_.exchange(read_, std::memory_order_release);
+    read_ = next;
+    read_index_ = 0;
+  }
+}
+
+channel::segment* channel::allocate() noexcept {
+  if (const auto entry = spare_.exchange(nullptr, std::memory_order_acquire)) {
+    return entry;
+  }
+  return new (std::nothrow) segment;
+}
+
+}  // namespace ice::detail
@@ -0,0 +1,79 @@
+#pragma once
+#include <ice/context.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace ice::detail {
+
+// Unbounded single-producer single-consumer queue of messages.
+//
+// Messages are stored in fixed-size segments. The producer links a new segment when the current one is full and the
+// consumer frees segments it read completely. One spare segment is kept to avoid allocations when the queue runs empty
+// at a segment boundary.
+//
+// The producer and the consumer close their side when they are done with the channel. The side that closes last
+// deletes it.
+class channel {
+public:
+  constexpr static std::size_t segment_size = 256;
+
+  enum side : std::uint8_t {
+    producer = 1,
+    consumer = 2,
+  };
+
+  channel() noexcept = default;
+
+  channel(channel&& other) = delete;
+  channel& operator=(channel&& other) = delete;
+
+  channel(const channel& other) = delete;
+  channel& operator=(const channel& other) = delete;
+
+  ~channel();
+
+  // Allocates the first segment. Returns false when the allocation failed.
+  bool reserve() noexcept;
+
+  // Adds a message. Returns false when a segment could not be allocated. Must only be called by the producer.
+  bool push(const detail::message& message) noexcept;
+
+  // Removes a message. Returns false when the queue is empty. Must only be called by the consumer.
+  bool pop(detail::message& message) noexcept;
+
+  // Closes the given side. Returns true when the other side was closed already and the caller must delete the channel.
+  bool close(side side) noexcept {
+    return state_.fetch_or(side, std::memory_order_acq_rel) != 0;
+  }
+
+  // Returns true when the given side was closed. Messages pushed before the producer closed are visible afterwards.
+  bool closed(side side) const noexcept {
+    return state_.load(std::memory_order_acquire) & side;
+  }
+
+  // Next channel of the context that receives the messages.
+  channel* next = nullptr;
+
+private:
+  struct segment {
+    detail::message entries[segment_size];
+    std::atomic<std::uint32_t> size = 0;
+    std::atomic<segment*> next = nullptr;
+  };
+
+  segment* allocate() noexcept;
+
+  // Consumer.
+  alignas(64) segment* read_ = nullptr;
+  std::uint32_t read_index_ = 0;
+
+  // Producer.
+  alignas(64) segment* write_ = nullptr;
+  std::uint32_t write_index_ = 0;
+
+  std::atomic<segment*> spare_ = nullptr;
+  std::atomic<std::uint8_t> state_ = 0;
+};
+
+}  // namespace ice::detail
@@ -1,12 +1,27 @@
 #include <ice/context.h>
+#include "channel.h"
+#include "wheel.h"
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <tuple>
+#include <utility>
 #include <vector>
+#include <cstring>
 
 #if ICE_OS_WIN32
 #  include <windows.h>
 #  include <winsock2.h>
+#elif ICE_IO_URING
+#  include "ring.h"
+#  include <sys/syscall.h>
+#  include <cerrno>
+#  include <unistd.h>
 #elif ICE_OS_LINUX
+#  include "descriptor.h"
 #  include <sys/epoll.h>
 #  include <sys/eventfd.h>
+#  include <cerrno>
 #  include <unistd.h>
 #elif ICE_OS_FREEBSD
 #  include <sys/event.h>
@@ -18,6 +33,9 @@ namespace detail {
 
 #if ICE_OS_WIN32
 
+// Status of overlapped operations that were canceled with CancelIoEx.
+constexpr ULONG_PTR status_cancelled = 0xC0000120;
+
 struct wsa {
   wsa() {
     WSADATA wsadata = {};
@@ -34,6 +52,128 @@ struct wsa {
 
 #endif
 
+// Completion entry returned by the system.
+#if ICE_OS_WIN32
+using entry = OVERLAPPED_ENTRY;
+#else
+using entry = ice::native_event;
+#endif
+
+// Counters of a thread that runs a context. Only that thread writes them, other threads take snapshots.
+class counters {
+public:
+  void record(std::size_t count, std::size_t size) noexcept {
+    increment(waits, 1);
+    increment(events, count);
+    if (count == size) {
+      increment(full, 1);
+    }
+    std::size_t bucket = 0;
+    for (; count && bucket + 1 < histogram.size(); count >>= 1) {
+      bucket++;
+    }
+    increment(histogram[bucket], 1);
+  }
+
+  void spin() noexcept {
+    increment(spins, 1);
+  }
+
+  ice::context::counters get() const noexcept {
+    ice::context::counters result;
+    result.waits = waits.load(std::memory_order_relaxed);
+    result.events = events.load(std::memory_order_relaxed);
+    result.full = full.load(std::memory_order_relaxed);
+    result.spins = spins.load(std::memory_order_relaxed);
+    for (std::size_t i = 0; i < histogram.size(); i++) {
+      result.histogram[i] = histogram[i].load(std::memory_order_relaxed);
+    }
+    result.event_buffer_size = event_buffer_size.load(std::memory_order_relaxed);
+    result.running = running.load(std::memory_order_relaxed);
+    return result;
+  }
+
+  std::atomic_uint64_t waits = 0;
+  std::atomic_uint64_t events = 0;
+  std::atomic_uint64_t full = 0;
+  std::atomic_uint64_t spins = 0;
+  std::array<std::atomic_uint64_t, std::tuple_size_v<decltype(ice::context::counters::histogram)>> histogram = {};
+  std::atomic_size_t event_buffer_size = 0;
+  std::atomic_bool running = false;
+
+private:
+  // Avoids locked instructions, because there is only one writer.
+  static void increment(std::atomic_uint64_t& counter, std::uint64_t value) noexcept {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+  }
+};
+
+// Set while the channels of the thread exist. Threads that send during thread exit after they were destroyed fail.
+thread_local bool g_channels_alive = false;
+thread_local bool g_channels_created = false;
+
+// Channels that the thread sends messages through. Closes them when the thread exits, so that the contexts free them
+// after they received the remaining messages.
+class channel_list {
+public:
+  channel_list() noexcept {
+    g_channels_alive = true;
+  }
+
+  channel_list(channel_list&& other) = delete;
+  channel_list& operator=(channel_list&& other) = delete;
+
+  channel_list(const channel_list& other) = delete;
+  channel_list& operator=(const channel_list& other) = delete;
+
+  ~channel_list() {
+    g_channels_alive = false;
+    for (const auto channel : channels_) {
+      if (channel->close(detail::channel::producer)) {
+        delete channel;
+      }
+    }
+  }
+
+  // Adds a channel. Frees the channels of destroyed contexts. Returns false when memory could not be allocated.
+  bool add(detail::channel* channel) noexcept {
+    const auto closed = [](detail::channel* channel) noexcept {
+      if (!channel->closed(detail::channel::consumer)) {
+        return false;
+      }
+      channel->close(detail::channel::producer);
+      delete channel;
+      return true;
+    };
+    channels_.erase(std::remove_if(channels_.begin(), channels_.end(), closed), channels_.end());
+    try {
+      channels_.push_back(channel);
+    }
+    catch (...) {
+      return false;
+    }
+    return true;
+  }
+
+private:
+  std::vector<detail::channel*> channels_;
+};
+
+// Returns the channels of the calling thread or nullptr when they could not be created or were already destroyed.
+channel_list* channels() noexcept {
+  if (g_channels_created && !g_channels_alive) {
+    return nullptr;
+  }
+  g_channels_created = true;
+  try {
+    thread_local channel_list channels;
+    return &channels;
+  }
+  catch (...) {
+    return nullptr;
+  }
+}
+
 }  // namespace detail
 
 #if ICE_OS_WIN32
@@ -51,13 +191,20 @@ void context::close_type::operator()(int handle) noexcept {
 
 #endif
 
-context::context() {
+context::context([[maybe_unused]] trigger mode) {
 #if ICE_OS_WIN32
   static const detail::wsa wsa;
   handle_type handle(::CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 0));
   if (!handle) {
     throw ice::system_error(::GetLastError(), "create context");
   }
+#elif ICE_IO_URING
+  io_uring_params params = {};
+  handle_type handle(static_cast<int>(::syscall(__NR_io_uring_setup, 1024, &params)));
+  if (!handle) {
+    throw ice::system_error(errno, "create context");
+  }
+  ring_ = std::make_unique<detail::ring>(handle, params);
 #elif ICE_OS_LINUX
   handle_type handle(::epoll_create1(0));
   if (!handle) {
@@ -72,6 +219,7 @@ context::context() {
     throw ice::system_error(errno, "add context event");
   }
   events_ = std::move(events);
+  descriptors_ = std::make_unique<detail::descriptor_table>(mode == trigger::edge);
 #elif ICE_OS_FREEBSD
   handle_type handle(::kqueue());
   if (!handle) {
@@ -84,92 +232,273 @@ context::context() {
   }
 #endif
   handle_ = std::move(handle);
+  wheel_ = std::make_unique<detail::wheel>();
 }
 
 context::~context() {
   [[maybe_unused]] const auto state = state_.fetch_or(stop_requested_flag, std::memory_order_release);
   [[maybe_unused]] const auto thread_count = state / thread_count_increment;
   assert(thread_count == 0);
+  // Messages that were not received are destroyed without calling them. Channels of threads that are still running
+  // are freed when those threads exit.
+  for (auto channel = channels_.load(std::memory_order_acquire); channel;) {
+    const auto next = channel->next;
+    detail::message message;
+    while (channel->pop(message)) {
+      if (message.destroy) {
+        message.destroy(message.data);
+      }
+    }
+    if (channel->close(detail::channel::consumer)) {
+      delete channel;
+    }
+    channel = next;
+  }
 }
 
 void context::run(std::size_t event_buffer_size) {
-#if ICE_OS_WIN32
-  using data_type = OVERLAPPED_ENTRY;
-  using size_type = ULONG;
-#else
-  using data_type = ice::native_event;
-  using size_type = int;
-#endif
+  const auto adaptive = event_buffer_size == 0;
+  if (adaptive) {
+    event_buffer_size = min_event_buffer_size;
+  }
 
   ice::error_code ec;
-  std::vector<data_type> events;
+  std::vector<detail::entry> events;
   events.resize(event_buffer_size);
 
-  const auto events_data = events.data();
-  const auto events_size = static_cast<size_type>(events.size());
+  // The buffer only grows. Shrinking it passes a smaller size to the poll and keeps the memory for the next growth.
+  auto events_size = events.size();
+  std::size_t events_unused = 0;
+
+  // Start of the current period without work while spinning.
+  auto idle = false;
+  clock::time_point idle_time;
+
+  auto& counters = acquire();
+  counters.event_buffer_size.store(event_buffer_size, std::memory_order_relaxed);
 
   index_.set(this);
   state_.fetch_add(thread_count_increment, std::memory_order_relaxed);
   while (true) {
-#if ICE_OS_WIN32
-    size_type count = 0;
-    if (!::GetQueuedCompletionStatusEx(handle_.as<HANDLE>(), events_data, events_size, &count, INFINITE, FALSE)) {
-      if (const auto rc = ::GetLastError(); rc != ERROR_ABANDONED_WAIT_0) {
-        ec = rc;
+    // Queued events are resumed in batches between polls for completions, which only block when the queue is empty.
+    drain();
+    const auto pending = queued();
+    auto timeout = pending ? 0 : wheel_->timeout();
+    auto spinning = false;
+    if (pending) {
+      idle = false;
+    } else if (const auto spin = this->spin(); timeout && spin.count() > 0) {
+      const auto now = clock::now();
+      if (!idle) {
+        idle = true;
+        idle_time = now;
+      }
+      if (now - idle_time < spin) {
+        timeout = 0;
+        spinning = true;
       }
-      break;
     }
-#elif ICE_OS_LINUX
-    const auto count = ::epoll_wait(handle_, events_data, events_size, -1);
-    if (count < 0 && errno != EINTR) {
-      ec = errno;
+    bool interrupted = false;
+    const auto count = wait(events.data(), events_size, timeout, interrupted, ec);
+    if (count < 0) {
       break;
     }
-#elif ICE_OS_FREEBSD
-    const auto count = ::kevent(handle_, nullptr, 0, events_data, events_size, nullptr);
-    if (count < 0 && errno != EINTR) {
-      ec = errno;
-      break;
+    const auto used = static_cast<std::size_t>(count);
+    if (used) {
+      idle = false;
+    } else if (spinning) {
+      counters.spin();
+      wheel_->expire();
+      continue;
     }
-#endif
-    bool interrupted = false;
-    for (size_type i = 0; i < count; i++) {
-      auto& entry = events_data[i];
-#if ICE_OS_WIN32
-      if (const auto ev = static_cast<ice::event*>(reinterpret_cast<ice::event_base*>(entry.lpOverlapped))) {
-        ev->await_resume();
-        continue;
-      }
-#elif ICE_OS_LINUX
-      if (const auto ev = reinterpret_cast<ice::event*>(entry.data.ptr)) {
-        ev->await_resume();
-        continue;
-      }
-#elif ICE_OS_FREEBSD
-      if (const auto ev = reinterpret_cast<ice::event*>(entry.udata)) {
-        ev->await_resume();
-        continue;
+    counters.record(used, events_size);
+    if (adaptive) {
+      if (used == events_size && events_size < max_event_buffer_size) {
+        events_size *= 2;
+        if (events.size() < events_size) {
+          events.resize(events_size);
+        }
+        events_unused = 0;
+      } else if (used < events_size / 4 && events_size > min_event_buffer_size) {
+        if (++events_unused == event_buffer_shrink_delay) {
+          events_size /= 2;
+          events_unused = 0;
+        }
+      } else {
+        events_unused = 0;
       }
-#endif
-      interrupted = true;
+      counters.event_buffer_size.store(events_size, std::memory_order_relaxed);
     }
     if (interrupted) {
       if (state_.load(std::memory_order_acquire) & stop_requested_flag) {
         break;
       }
     }
+    wheel_->expire();
   }
   state_.fetch_sub(thread_count_increment, std::memory_order_release);
   index_.set(nullptr);
+  release(counters);
   interrupt();
   if (ec) {
     throw ice::system_error(ec, "context");
   }
 }
 
+std::size_t context::poll() {
+  return run_one(clock::duration::zero());
+}
+
+std::size_t context::run_one(clock::duration timeout) {
+  std::array<detail::entry, min_event_buffer_size> events;
+
+  ice::error_code ec;
+  auto& counters = acquire();
+  counters.event_buffer_size.store(events.size(), std::memory_order_relaxed);
+
+  index_.set(this);
+  state_.fetch_add(thread_count_increment, std::memory_order_relaxed);
+  auto resumed = drain();
+  auto interrupted = false;
+  auto milliseconds = 0;
+  if (!resumed && !queued() && timeout > clock::duration::zero()) {
+    const auto limit = std::chrono::ceil<std::chrono::milliseconds>(timeout).count();
+    milliseconds = static_cast<int>(std::min<decltype(limit)>(limit, std::numeric_limits<int>::max()));
+    if (const auto next = wheel_->timeout(); next >= 0 && next < milliseconds) {
+      milliseconds = next;
+    }
+  }
+  // Only the first poll waits. The others take the completions that did not fit into the buffer, up to the size of
+  // the largest buffer of run(), so that a busy context returns to the calling loop.
+  for (std::size_t i = 0; i < max_event_buffer_size / events.size(); i++) {
+    const auto count = wait(events.data(), events.size(), milliseconds, interrupted, ec);
+    if (count < 0) {
+      break;
+    }
+    counters.record(static_cast<std::size_t>(count), events.size());
+    resumed += static_cast<std::size_t>(count);
+    if (static_cast<std::size_t>(count) < events.size()) {
+      break;
+    }
+    milliseconds = 0;
+  }
+  wheel_->expire();
+  state_.fetch_sub(thread_count_increment, std::memory_order_release);
+  index_.set(nullptr);
+  release(counters);
+
+#if ICE_IO_URING
+  // Submit entries that were queued while resuming events, so that their completions make the handle readable.
+  if (const auto rc = ring_->submit(); rc && rc != EINTR && rc != EAGAIN && rc != EBUSY && !ec) {
+    ec = rc;
+  }
+#endif
+  // Events queued while resuming events did not interrupt the context. Pass a consumed stop request on to threads
+  // that run the context.
+  if (queued() || (interrupted && (state_.load() & stop_requested_flag))) {
+    interrupt();
+  }
+  if (ec) {
+    throw ice::system_error(ec, "context");
+  }
+  return resumed;
+}
+
+std::chrono::milliseconds context::poll_timeout() noexcept {
+  if (queued()) {
+    return std::chrono::milliseconds(0);
+  }
+  return std::chrono::milliseconds(wheel_->timeout());
+}
+
+int context::wait(void* entries, std::size_t size, int timeout, bool& interrupted, ice::error_code& ec) noexcept {
+#if ICE_OS_WIN32
+  using size_type = ULONG;
+#else
+  using size_type = int;
+#endif
+  const auto events_data = static_cast<detail::entry*>(entries);
+  [[maybe_unused]] const auto events_size = static_cast<size_type>(size);
+#if ICE_OS_WIN32
+  size_type count = 0;
+  const auto milliseconds = timeout < 0 ? INFINITE : static_cast<DWORD>(timeout);
+  if (!::GetQueuedCompletionStatusEx(handle_.as<HANDLE>(), events_data, events_size, &count, milliseconds, FALSE)) {
+    if (const auto rc = ::GetLastError(); rc != WAIT_TIMEOUT) {
+      if (rc != ERROR_ABANDONED_WAIT_0) {
+        ec = rc;
+      }
+      return -1;
+    }
+  }
+#elif ICE_IO_URING
+  if (const auto rc = ring_->wait(timeout); rc && rc != EINTR && rc != EAGAIN && rc != EBUSY) {
+    ec = rc;
+    return -1;
+  }
+  const auto count = static_cast<size_type>(ring_->pop(events_data, size));
+#elif ICE_OS_LINUX
+  auto count = ::epoll_wait(handle_, events_data, events_size, timeout);
+  if (count < 0) {
+    if (errno != EINTR) {
+      ec = errno;
+      return -1;
+    }
+    count = 0;
+  }
+#elif ICE_OS_FREEBSD
+  timespec ts = { timeout / 1000, (timeout % 1000) * 1000000 };
+  auto count = ::kevent(handle_, nullptr, 0, events_data, events_size, timeout < 0 ? nullptr : &ts);
+  if (count < 0) {
+    if (errno != EINTR) {
+      ec = errno;
+      return -1;
+    }
+    count = 0;
+  }
+#endif
+  for (size_type i = 0; i < count; i++) {
+    auto& entry = events_data[i];
+#if ICE_OS_WIN32
+    if (const auto ev = static_cast<ice::event*>(reinterpret_cast<ice::event_base*>(entry.lpOverlapped))) {
+      if (entry.lpOverlapped->Internal == detail::status_cancelled && ev->reason_.load()) {
+        ev->ec_ = ev->reason();
+      }
+      ev->await_resume();
+      continue;
+    }
+#elif ICE_IO_URING
+    if (const auto base = reinterpret_cast<ice::event_base*>(entry.user_data)) {
+      std::memcpy(&base->storage, &entry, sizeof(entry));
+      const auto ev = static_cast<ice::event*>(base);
+      if ((entry.res == -ECANCELED || entry.res == -EINTR) && ev->reason_.load()) {
+        ev->ec_ = ev->reason();
+      }
+      ev->await_resume();
+      continue;
+    }
+#elif ICE_OS_LINUX
+    if (const auto descriptor = reinterpret_cast<detail::descriptor*>(entry.data.ptr)) {
+      descriptor->dispatch(handle_, entry.events);
+      continue;
+    }
+#elif ICE_OS_FREEBSD
+    if (const auto ev = reinterpret_cast<ice::event*>(entry.udata)) {
+      ev->await_resume();
+      continue;
+    }
+#endif
+    interrupted = true;
+  }
+  return static_cast<int>(count);
+}
+
 void context::interrupt() noexcept {
 #if ICE_OS_WIN32
   ::PostQueuedCompletionStatus(handle_.as<HANDLE>(), 0, 0, nullptr);
+#elif ICE_IO_URING
+  io_uring_sqe sqe = {};
+  sqe.opcode = IORING_OP_NOP;
+  ring_->push(sqe, true);
 #elif ICE_OS_LINUX
   static epoll_event nev{ EPOLLOUT | EPOLLONESHOT, {} };
   ::epoll_ctl(handle_, EPOLL_CTL_MOD, events_, &nev);
@@ -180,6 +509,73 @@ void context::interrupt() noexcept {
 #endif
 }
 
+void context::arm(detail::timer& timer, clock::time_point time) noexcept {
+  if (wheel_->add(timer, time) && !is_current()) {
+    interrupt();
+  }
+}
+
+bool context::disarm(detail::timer& timer) noexcept {
+  return wheel_->remove(timer);
+}
+
+void context::queue(ice::event* ev) noexcept {
+  auto head = queue_.load(std::memory_order_relaxed);
+  do {
+    ev->next_ = head;
+  } while (!queue_.compare_exchange_weak(head, ev, std::memory_order_release, std::memory_order_relaxed));
+  if (!head && !is_current()) {
+    interrupt();
+  }
+}
+
+#if !ICE_OS_WIN32
+
+void context::attach([[maybe_unused]] int handle) noexcept {
+#  if ICE_OS_LINUX && !ICE_IO_URING
+  if (const auto descriptor = descriptors_->get(handle)) {
+    // Operations that still waited when the previous descriptor with this number was closed must not be resumed by
+    // readiness of the new one.
+    for (const auto ev : descriptor->reset()) {
+      if (ev) {
+        ev->ec_ = EBADF;
+        queue(ev);
+      }
+    }
+  }
+#  endif
+}
+
+#endif
+
+std::vector<context::counters> context::statistics() const {
+  std::lock_guard lock(counters_mutex_);
+  std::vector<counters> result;
+  result.reserve(counters_.size());
+  for (const auto& entry : counters_) {
+    result.push_back(entry->get());
+  }
+  return result;
+}
+
+detail::counters& context::acquire() {
+  std::lock_guard lock(counters_mutex_);
+  for (auto& entry : counters_) {
+    if (!entry->running.load(std::memory_order_relaxed)) {
+      entry->running.store(true, std::memory_order_relaxed);
+      return *entry;
+    }
+  }
+  counters_.push_back(std::make_unique<detail::counters>());
+  counters_.back()->running.store(true, std::memory_order_relaxed);
+  return *counters_.back();
+}
+
+void context::release(detail::counters& counters) noexcept {
+  std::lock_guard lock(counters_mutex_);
+  counters.running.store(false, std::memory_order_relaxed);
+}
+
 bool context::stop() noexcept {
   const auto state = state_.fetch_or(stop_requested_flag, std::memory_order_release);
   const auto thread_count = state / thread_count_increment;
@@ -187,18 +583,117 @@ bool context::stop() noexcept {
   return thread_count == 0;
 }
 
+bool context::send(detail::message message) noexcept {
+  auto channel = static_cast<detail::channel*>(sender_.get());
+  if (!channel || !detail::g_channels_alive) {
+    // The channel belongs to both this thread and the context. Whichever of them is done with it last frees it.
+    const auto channels = detail::channels();
+    if (!channels) {
+      return false;
+    }
+    std::unique_ptr<detail::channel> entry(new (std::nothrow) detail::channel);
+    if (!entry || !entry->reserve() || !channels->add(entry.get())) {
+      return false;
+    }
+    channel = entry.release();
+    auto head = channels_.load(std::memory_order_relaxed);
+    do {
+      channel->next = head;
+    } while (!channels_.compare_exchange_weak(head, channel, std::memory_order_release, std::memory_order_relaxed));
+    sender_.set(channel);
+  }
+  if (!channel->push(message)) {
+    return false;
+  }
+  // Only the first message after the context received messages interrupts it.
+  if (!signaled_.exchange(true) && !is_current()) {
+    interrupt();
+  }
+  return true;
+}
+
+std::size_t context::receive(std::size_t limit) noexcept {
+  std::size_t count = 0;
+  // Only one thread reads the channels at a time. A thread that finds them busy leaves the messages to the reading
+  // thread, which checks the signal again after it stopped reading.
+  while (count < limit && signaled_.load() && !receiving_.exchange(true, std::memory_order_acquire)) {
+    if (signaled_.exchange(false)) {
+      detail::channel* prev = nullptr;
+      for (auto channel = channels_.load(std::memory_order_acquire); channel;) {
+        // Messages are pushed before the producer closes the channel, so a closed channel that runs empty stays empty.
+        const auto closed = channel->closed(detail::channel::producer);
+        detail::message message;
+        while (count < limit && channel->pop(message)) {
+          message.call(message.data);
+          count++;
+        }
+        const auto next = channel->next;
+        if (closed && count < limit) {
+          unlink(prev, channel);
+          delete channel;
+        } else {
+          prev = channel;
+        }
+        channel = next;
+      }
+      if (count == limit) {
+        signaled_.store(true);
+      }
+    }
+    receiving_.store(false);
+  }
+  return count;
+}
+
+void context::unlink(detail::channel* prev, detail::channel* channel) noexcept {
+  // Senders only replace the head, so only a channel at the head can have new predecessors.
+  if (!prev) {
+    auto head = channel;
+    if (channels_.compare_exchange_strong(head, channel->next, std::memory_order_acquire)) {
+      return;
+    }
+    for (prev = head; prev->next != channel;) {
+      prev = prev->next;
+    }
+  }
+  prev->next = channel->next;
+}
+
+std::size_t context::drain() noexcept {
+  auto count = receive(queue_batch_size);
+  while (count < queue_batch_size && queue_.load(std::memory_order_relaxed)) {
+    // The queue is a stack. Reverse it to resume events in the order they were queued.
+    ice::event* head = nullptr;
+    for (auto ev = queue_.exchange(nullptr, std::memory_order_acquire); ev;) {
+      const auto next = ev->next_;
+      ev->next_ = head;
+      head = ev;
+      ev = next;
+    }
+    while (head) {
+      const auto ev = head;
+      head = head->next_;
+      ev->await_resume();
+      count++;
+    }
+  }
+  return count;
+}
+
 bool schedule::suspend() noexcept {
-#if ICE_OS_WIN32
-  if (!::PostQueuedCompletionStatus(context_.as<HANDLE>(), 0, 0, get())) {
-    ec_ = ::GetLastError();
+  context_.queue(this);
+  return true;
+}
+
+bool transfer::suspend() noexcept {
+  const auto call = [](void* data) noexcept {
+    static_cast<ice::event*>(data)->await_resume();
+  };
+  if (!context_.send({ call, nullptr, static_cast<ice::event*>(this) })) {
+    ec_ = std::errc::not_enough_memory;
     return false;
   }
   return true;
-#elif ICE_OS_LINUX
-  return queue_note(context_, handle_);
-#elif ICE_OS_FREEBSD
-  return queue_note(context_, 0);
-#endif
 }
 
 }  // namespace ice
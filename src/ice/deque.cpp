@@ -0,0 +1,74 @@
+#include "deque.h"
+#include <new>
+
+namespace ice::detail {
+
+deque::deque() {
+  buffers_.push_back(std::make_unique<buffer>(initial_capacity));
+  buffer_.store(buffers_.back().get(), std::memory_order_relaxed);
+}
+
+bool deque::push(ice::event* ev) noexcept {
+  const auto bottom = bottom_.load(std::memory_order_relaxed);
+  const auto top = top_.load(std::memory_order_acquire);
+  auto current = buffer_.load(std::memory_order_relaxed);
+  if (bottom - top > static_cast<std::int64_t>(current->capacity()) - 1) {
+    try {
+      current = grow(current, top, bottom);
+    }
+    catch (const std::bad_alloc&) {
+      return false;
+    }
+  }
+  current->put(bottom, ev);
+  std::atomic_thread_fence(std::memory_order_release);
+  bottom_.store(bottom + 1, std::memory_order_relaxed);
+  return true;
+}
+
+ice::event* deque::take() noexcept {
+  const auto bottom = bottom_.load(std::memory_order_relaxed) - 1;
+  const auto current = buffer_.load(std::memory_order_relaxed);
+  bottom_.store(bottom, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  auto top = top_.load(std::memory_order_relaxed);
+  if (top > bottom) {
+    bottom_.store(bottom + 1, std::memory_order_relaxed);
+    return nullptr;
+  }
+  auto ev = current->get(bottom);
+  if (top == bottom) {
+    // The last event is taken by whoever moves the top first.
+    if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+      ev = nullptr;
+    }
+    bottom_.store(bottom + 1, std::memory_order_relaxed);
+  }
+  return ev;
+}
+
+ice::event* deque::steal() noexcept {
+  auto top = top_.load(std::memory_order_acquire);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  const auto bottom = bottom_.load(std::memory_order_acquire);
+  if (top >= bottom) {
+    return nullptr;
+  }
+  const auto ev = buffer_.load(std::memory_order_acquire)->get(top);
+  if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+    return nullptr;
+  }
+  return ev;
+}
+
+deque::buffer* deque::grow(buffer* current, std::int64_t top, std::int64_t bottom) {
+  auto next = std::make_unique<buffer>(current->capacity() * 2);
+  for (auto i = top; i < bottom; i++) {
+    next->put(i, current->get(i));
+  }
+  buffers_.push_back(std::move(next));
+  buffer_.store(buffers_.back().get(), std::memory_order_release);
+  return buffers_.back().get();
+}
+
+}  // namespace ice::detail
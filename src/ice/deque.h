@@ -0,0 +1,71 @@
+#pragma once
+#include <ice/event.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace ice::detail {
+
+// Chase-Lev work-stealing deque of events.
+//
+// The owner pushes and takes events at the bottom. Other threads steal events from the top. The buffer grows when it
+// is full and previous buffers are kept until the deque is destroyed, because thieves may still read from them.
+class deque {
+public:
+  constexpr static std::size_t initial_capacity = 256;
+
+  deque();
+
+  deque(deque&& other) = delete;
+  deque& operator=(deque&& other) = delete;
+
+  deque(const deque& other) = delete;
+  deque& operator=(const deque& other) = delete;
+
+  ~deque() = default;
+
+  // Adds an event at the bottom. Returns false when the buffer could not grow. Must only be called by the owner.
+  bool push(ice::event* ev) noexcept;
+
+  // Removes the event at the bottom or returns nullptr. Must only be called by the owner.
+  ice::event* take() noexcept;
+
+  // Removes the event at the top or returns nullptr when the deque is empty or another thread won the race.
+  ice::event* steal() noexcept;
+
+  bool empty() const noexcept {
+    return bottom_.load(std::memory_order_relaxed) <= top_.load(std::memory_order_relaxed);
+  }
+
+private:
+  struct buffer {
+    explicit buffer(std::size_t capacity) : mask(capacity - 1), entries(new std::atomic<ice::event*>[capacity]) {
+    }
+
+    ice::event* get(std::int64_t index) const noexcept {
+      return entries[static_cast<std::size_t>(index) & mask].load(std::memory_order_relaxed);
+    }
+
+    void put(std::int64_t index, ice::event* ev) noexcept {
+      entries[static_cast<std::size_t>(index) & mask].store(ev, std::memory_order_relaxed);
+    }
+
+    std::size_t capacity() const noexcept {
+      return mask + 1;
+    }
+
+    const std::size_t mask;
+    const std::unique_ptr<std::atomic<ice::event*>[]> entries;
+  };
+
+  buffer* grow(buffer* current, std::int64_t top, std::int64_t bottom);
+
+  alignas(64) std::atomic<std::int64_t> top_ = 0;
+  alignas(64) std::atomic<std::int64_t> bottom_ = 0;
+  std::atomic<buffer*> buffer_ = nullptr;
+  std::vector<std::unique_ptr<buffer>> buffers_;
+};
+
+}  // namespace ice::detail
@@ -0,0 +1,260 @@
+#include "descriptor.h"
+
+#if ICE_OS_LINUX && !ICE_IO_URING
+#  include <new>
+#  include <sys/epoll.h>
+
+namespace ice::detail {
+
+namespace {
+
+constexpr std::uint32_t edge_events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+
+}  // namespace
+
+void descriptor::drain_recv(std::uint32_t state) noexcept {
+  if (edge_ && !(state & closed)) {
+    recv_state_.compare_exchange_strong(state, state | drained);
+  }
+}
+
+bool descriptor::queue_recv(int context, ice::event* ev, std::uint32_t state, ice::error_code& ec) noexcept {
+  return queue(context, recv_, recv_state_, EPOLLIN, ev, state, ec);
+}
+
+bool descriptor::queue_send(int context, ice::event* ev, std::uint32_t state, ice::error_code& ec) noexcept {
+  return queue(context, send_, send_state_, EPOLLOUT, ev, state, ec);
+}
+
+bool descriptor::queue_error(int context, ice::event* ev, std::uint32_t state, ice::error_code& ec) noexcept {
+  return queue(context, error_, error_state_, EPOLLERR, ev, state, ec);
+}
+
+bool descriptor::cancel(int context, ice::event* ev) noexcept {
+  std::uint32_t events = 0;
+  if (auto expected = ev; recv_.compare_exchange_strong(expected, nullptr)) {
+    events = EPOLLIN;
+  } else if (expected = ev; send_.compare_exchange_strong(expected, nullptr)) {
+    events = EPOLLOUT;
+  } else if (expected = ev; error_.compare_exchange_strong(expected, nullptr)) {
+    events = EPOLLERR;
+  } else {
+    return false;
+  }
+  if (!edge_) {
+    remove(context, events);
+  }
+  return true;
+}
+
+void descriptor::dispatch(int context, std::uint32_t events) noexcept {
+  ice::event* recv = nullptr;
+  ice::event* send = nullptr;
+  ice::event* error = nullptr;
+  if (events & EPOLLERR) {
+    if (edge_) {
+      notify(error_state_, 0);
+    }
+    // Completions of zero-copy sends make the error queue readable and are reported as EPOLLERR. They only concern
+    // the operation that waits for them unless the socket hung up. Without such an operation the other directions
+    // are woken, so that they see errors that the socket reports without hanging up.
+    if (error = error_.exchange(nullptr); error && !(events & (EPOLLHUP | EPOLLRDHUP))) {
+      events &= ~static_cast<std::uint32_t>(EPOLLERR);
+    }
+  }
+  if (!edge_ && (error || (events & (EPOLLERR | EPOLLHUP)))) {
+    // Errors and hangups are reported without interest. Error interest only keeps the descriptor registered while an
+    // operation waits for the error queue and would otherwise keep reporting a hung up descriptor on every wait.
+    remove(context, EPOLLERR);
+  }
+  if (edge_) {
+    // Only hangups end further edge notifications. Errors are reported by the next operation.
+    if (events & (EPOLLIN | EPOLLRDHUP | EPOLLERR | EPOLLHUP)) {
+      notify(recv_state_, events & (EPOLLRDHUP | EPOLLHUP) ? closed : 0);
+      recv = recv_.exchange(nullptr);
+    }
+    if (events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) {
+      notify(send_state_, events & EPOLLHUP ? closed : 0);
+      send = send_.exchange(nullptr);
+    }
+  } else {
+    if (events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+      if (recv = recv_.exchange(nullptr); !recv) {
+        remove(context, EPOLLIN);
+      }
+    }
+    if (events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) {
+      send = send_.exchange(nullptr);
+      remove(context, EPOLLOUT);
+    }
+  }
+  if (recv) {
+    recv->await_resume();
+  }
+  if (send) {
+    send->await_resume();
+  }
+  if (error) {
+    error->await_resume();
+  }
+}
+
+std::array<ice::event*, 3> descriptor::reset() noexcept {
+  lock();
+  recv_state_.store(0);
+  send_state_.store(0);
+  error_state_.store(0);
+  events_.store(0);
+  registered_ = false;
+  unlock();
+  return { recv_.exchange(nullptr), send_.exchange(nullptr), error_.exchange(nullptr) };
+}
+
+bool descriptor::queue(int context, std::atomic<ice::event*>& slot, std::atomic<std::uint32_t>& state,
+  std::uint32_t events, ice::event* ev, std::uint32_t sample, ice::error_code& ec) noexcept {
+  slot.store(ev);
+  // The event belongs to the thread that takes it from the slot and must not be touched after it was parked.
+  if (const auto rc = add(context, events)) {
+    if (slot.compare_exchange_strong(ev, nullptr)) {
+      ec = rc;
+      return false;
+    }
+    return true;
+  }
+  if (!edge_) {
+    return true;
+  }
+  // The direction stays drained until the next edge notification. If one arrived after the sample, the failed
+  // operation may have missed it and must be retried unless the notification already took the event.
+  if (auto expected = sample; state.compare_exchange_strong(expected, sample | drained)) {
+    return true;
+  }
+  return !slot.compare_exchange_strong(ev, nullptr);
+}
+
+ice::error_code descriptor::add(int context, std::uint32_t events) noexcept {
+  if (edge_) {
+    events = edge_events;
+  }
+  if ((events_.load() & events) == events) {
+    return {};
+  }
+  lock();
+  ice::error_code ec;
+  if (const auto current = events_.load(); (current & events) != events) {
+    events_.store(current | events);
+    ec = update(context, current | events);
+  }
+  unlock();
+  return ec;
+}
+
+ice::error_code descriptor::remove(int context, std::uint32_t events) noexcept {
+  lock();
+  ice::error_code ec;
+  if (const auto current = events_.load(); current & events) {
+    // Publish the reduced interest before checking the slots, so that a concurrent queue_recv or queue_send
+    // either sees the reduced interest and registers it again or is seen here and keeps it.
+    auto update_events = current & ~events;
+    events_.store(update_events);
+    if ((events & EPOLLIN) && recv_.load()) {
+      update_events |= EPOLLIN;
+    }
+    if ((events & EPOLLOUT) && send_.load()) {
+      update_events |= EPOLLOUT;
+    }
+    if ((events & EPOLLERR) && error_.load()) {
+      update_events |= EPOLLERR;
+    }
+    if (update_events != current) {
+      events_.store(update_events);
+      ec = update(context, update_events);
+    }
+  }
+  unlock();
+  return ec;
+}
+
+ice::error_code descriptor::update(int context, std::uint32_t events) noexcept {
+  // Hangups and errors are reported even without interest, so descriptors without waiters are removed.
+  if (!events) {
+    registered_ = false;
+    if (::epoll_ctl(context, EPOLL_CTL_DEL, handle_, nullptr) < 0 && errno != ENOENT) {
+      return errno;
+    }
+    return {};
+  }
+  epoll_event nev = {};
+  nev.events = events;
+  nev.data.u64 = reinterpret_cast<std::uintptr_t>(this);
+  auto op = registered_ ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+  while (::epoll_ctl(context, op, handle_, &nev) < 0) {
+    // The registration is lost when the descriptor is closed and may still exist when it was never reset.
+    if (op == EPOLL_CTL_MOD && errno == ENOENT) {
+      op = EPOLL_CTL_ADD;
+    } else if (op == EPOLL_CTL_ADD && errno == EEXIST) {
+      op = EPOLL_CTL_MOD;
+    } else {
+      return errno;
+    }
+  }
+  registered_ = true;
+  return {};
+}
+
+void descriptor::notify(std::atomic<std::uint32_t>& state, std::uint32_t flags) noexcept {
+  auto current = state.load();
+  while (!state.compare_exchange_weak(current, ((current & ~drained) + increment) | flags)) {
+  }
+}
+
+void descriptor::lock() noexcept {
+  while (lock_.test_and_set(std::memory_order_acquire)) {
+  }
+}
+
+void descriptor::unlock() noexcept {
+  lock_.clear(std::memory_order_release);
+}
+
+descriptor_table::descriptor_table(bool edge) : chunks_(new std::atomic<descriptor*>[chunk_count]), edge_(edge) {
+  for (std::size_t i = 0; i < chunk_count; i++) {
+    chunks_[i].store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+descriptor_table::~descriptor_table() {
+  for (std::size_t i = 0; i < chunk_count; i++) {
+    delete[] chunks_[i].load(std::memory_order_relaxed);
+  }
+}
+
+descriptor* descriptor_table::get(int handle) noexcept {
+  const auto index = static_cast<std::size_t>(handle);
+  if (handle < 0 || index >= chunk_size * chunk_count) {
+    return nullptr;
+  }
+  auto& entry = chunks_[index / chunk_size];
+  auto chunk = entry.load(std::memory_order_acquire);
+  if (!chunk) {
+    const auto created = new (std::nothrow) descriptor[chunk_size];
+    if (!created) {
+      return nullptr;
+    }
+    const auto first = static_cast<int>(index / chunk_size * chunk_size);
+    for (std::size_t i = 0; i < chunk_size; i++) {
+      created[i].handle_ = first + static_cast<int>(i);
+      created[i].edge_ = edge_;
+    }
+    if (entry.compare_exchange_strong(chunk, created, std::memory_order_acq_rel, std::memory_order_acquire)) {
+      chunk = created;
+    } else {
+      delete[] created;
+    }
+  }
+  return &chunk[index % chunk_size];
+}
+
+}  // namespace ice::detail
+
+#endif
@@ -0,0 +1,128 @@
+#pragma once
+#include <ice/config.h>
+
+#if ICE_OS_LINUX && !ICE_IO_URING
+#  include <ice/error.h>
+#  include <ice/event.h>
+#  include <array>
+#  include <atomic>
+#  include <memory>
+#  include <cstdint>
+#  include <cstddef>
+
+namespace ice::detail {
+
+// Epoll registration of a file descriptor with waiter slots for both directions and the socket error queue.
+//
+// In level-triggered mode the registration is kept between waits. Read interest stays registered while readers
+// come back for more data and is only dropped when the descriptor becomes readable without a waiting reader. Write
+// interest is dropped as soon as no writer waits for it.
+//
+// In edge-triggered mode the descriptor is registered for both directions once. Each direction keeps a readiness
+// state that counts edge notifications and records whether the descriptor was drained since the last one.
+//
+// Errors are reported without interest. The error queue slot registers EPOLLERR, which only keeps the descriptor
+// registered while an operation waits for it.
+class descriptor {
+public:
+  // Readiness state flags and the increment of the edge notification count.
+  constexpr static std::uint32_t drained = 1;
+  constexpr static std::uint32_t closed = 2;
+  constexpr static std::uint32_t increment = 4;
+
+  // Returns the current readiness state of the recv or send direction.
+  std::uint32_t recv_state() const noexcept {
+    return recv_state_.load();
+  }
+
+  std::uint32_t send_state() const noexcept {
+    return send_state_.load();
+  }
+
+  std::uint32_t error_state() const noexcept {
+    return error_state_.load();
+  }
+
+  // Returns false when the state shows that the direction was drained and has not been notified since.
+  constexpr static bool ready(std::uint32_t state) noexcept {
+    return !(state & drained) || (state & closed);
+  }
+
+  // Marks the recv direction as drained unless it was notified after the state was sampled.
+  void drain_recv(std::uint32_t state) noexcept;
+
+  // Parks the event in the recv or send slot and registers the matching interest if necessary.
+  // The state must be sampled before the operation failed with EAGAIN. Returns false without an error when the
+  // direction was notified after the state was sampled and the operation should be retried.
+  bool queue_recv(int context, ice::event* ev, std::uint32_t state, ice::error_code& ec) noexcept;
+  bool queue_send(int context, ice::event* ev, std::uint32_t state, ice::error_code& ec) noexcept;
+
+  // Parks the event in the error queue slot like queue_recv and queue_send.
+  bool queue_error(int context, ice::event* ev, std::uint32_t state, ice::error_code& ec) noexcept;
+
+  // Takes the event from its slot and drops the interest of a level-triggered registration without other waiters.
+  // Returns false when the event is not waiting.
+  bool cancel(int context, ice::event* ev) noexcept;
+
+  // Takes the events waiting for the reported readiness and resumes them.
+  void dispatch(int context, std::uint32_t events) noexcept;
+
+  // Forgets the registration and readiness state of a previously closed descriptor. Returns the events that were
+  // still parked when it was closed. The closed descriptor will never report them, so the caller must complete them.
+  std::array<ice::event*, 3> reset() noexcept;
+
+private:
+  friend class descriptor_table;
+
+  bool queue(int context, std::atomic<ice::event*>& slot, std::atomic<std::uint32_t>& state, std::uint32_t events,
+    ice::event* ev, std::uint32_t sample, ice::error_code& ec) noexcept;
+
+  ice::error_code add(int context, std::uint32_t events) noexcept;
+  ice::error_code remove(int context, std::uint32_t events) noexcept;
+  ice::error_code update(int context, std::uint32_t events) noexcept;
+
+  static void notify(std::atomic<std::uint32_t>& state, std::uint32_t flags) noexcept;
+
+  void lock() noexcept;
+  void unlock() noexcept;
+
+  std::atomic<ice::event*> recv_ = nullptr;
+  std::atomic<ice::event*> send_ = nullptr;
+  std::atomic<ice::event*> error_ = nullptr;
+  std::atomic<std::uint32_t> recv_state_ = 0;
+  std::atomic<std::uint32_t> send_state_ = 0;
+  std::atomic<std::uint32_t> error_state_ = 0;
+  std::atomic<std::uint32_t> events_ = 0;
+  std::atomic_flag lock_ = ATOMIC_FLAG_INIT;
+  bool registered_ = false;
+  bool edge_ = false;
+  int handle_ = -1;
+};
+
+// Descriptor registrations indexed by file descriptor.
+class descriptor_table {
+public:
+  constexpr static std::size_t chunk_size = 4096;
+  constexpr static std::size_t chunk_count = 4096;
+
+  explicit descriptor_table(bool edge);
+
+  descriptor_table(descriptor_table&& other) = delete;
+  descriptor_table& operator=(descriptor_table&& other) = delete;
+
+  descriptor_table(const descriptor_table& other) = delete;
+  descriptor_table& operator=(const descriptor_table& other) = delete;
+
+  ~descriptor_table();
+
+  // Returns the registration for the file descriptor or nullptr when out of memory or range.
+  descriptor* get(int handle) noexcept;
+
+private:
+  std::unique_ptr<std::atomic<descriptor*>[]> chunks_;
+  const bool edge_;
+};
+
+}  // namespace ice::detail
+
+#endif
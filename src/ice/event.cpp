@@ -1,9 +1,15 @@
 #include <ice/event.h>
+#include <ice/context.h>
 #include <new>
 
 #if ICE_OS_WIN32
 #  include <windows.h>
+#elif ICE_IO_URING
+#  include "ring.h"
+#  include <poll.h>
+#  include <cerrno>
 #elif ICE_OS_LINUX
+#  include "descriptor.h"
 #  include <sys/epoll.h>
 #elif ICE_OS_FREEBSD
 #  include <sys/event.h>
@@ -22,83 +28,244 @@ event::~event() {
   get()->~native_event();
 }
 
-#if ICE_OS_LINUX
+void event::cancel(ice::error_code ec) noexcept {
+  if (!cancelable_ || !ec) {
+    return;
+  }
+  users_.fetch_add(1);
+  if (auto expected = 0; reason_.compare_exchange_strong(expected, ec.combined())) {
+#if ICE_OS_WIN32
+    // Operations that are not started yet see the reason when they are.
+    if (const auto handle = native_handle_.load()) {
+      ::CancelIoEx(reinterpret_cast<HANDLE>(handle), get());
+    }
+#else
+    // Operations that are not queued yet see the reason when they are.
+    if (const auto context = native_context_.load(); context && withdraw(*context)) {
+      ec_ = ec;
+      context->queue(this);
+    }
+#endif
+  }
+  users_.fetch_sub(1, std::memory_order_release);
+}
 
-bool event::queue_recv(int context, int id) noexcept {
-  const auto nev = get();
-  native_context_ = context;
-  native_id_ = id;
-  nev->events = EPOLLIN | EPOLLONESHOT;
-  nev->data.ptr = this;
-  if (::epoll_ctl(context, EPOLL_CTL_ADD, id, nev) < 0) {
-    ec_ = errno;
-    return false;
+#if ICE_OS_WIN32
+
+bool event::enter(std::uintptr_t handle) noexcept {
+  if (cancelable_) {
+    users_.fetch_add(1);
+    native_handle_.store(handle);
+    return true;
+  }
+  return false;
+}
+
+void event::leave(bool cancelable) noexcept {
+  if (cancelable) {
+    if (reason_.load()) {
+      ::CancelIoEx(reinterpret_cast<HANDLE>(native_handle_.load()), get());
+    }
+    users_.fetch_sub(1, std::memory_order_release);
+  }
+}
+
+#else
+
+bool event::enter(ice::context& context) noexcept {
+  if (cancelable_) {
+    users_.fetch_add(1);
+    native_context_.store(&context);
+    return true;
+  }
+  return false;
+}
+
+bool event::leave(bool cancelable, bool queued) noexcept {
+  // The event must not be accessed after it was queued unless it is cancelable, which makes settle() wait for this.
+  if (cancelable) {
+    if (queued && reason_.load() && withdraw(*native_context_.load())) {
+      ec_ = reason();
+      queued = false;
+    }
+    users_.fetch_sub(1, std::memory_order_release);
+  }
+  return queued;
+}
+
+#endif
+
+#if ICE_IO_URING
+
+bool event::queue_recv(ice::context& context, int id) noexcept {
+  return queue(context, IORING_OP_POLL_ADD, id, nullptr, 0, 0, POLLIN);
+}
+
+bool event::queue_send(ice::context& context, int id) noexcept {
+  return queue(context, IORING_OP_POLL_ADD, id, nullptr, 0, 0, POLLOUT);
+}
+
+bool event::queue_error(ice::context& context, int id) noexcept {
+  return queue(context, IORING_OP_POLL_ADD, id, nullptr, 0, 0, POLLERR);
+}
+
+bool event::queue(ice::context& context, std::uint8_t opcode, int fd, const void* addr, std::uint32_t len,
+  std::uint64_t off, std::uint32_t flags) noexcept {
+  const auto cancelable = enter(context);
+  if (cancelable && reason_.load()) {
+    ec_ = reason();
+    return leave(cancelable, false);
+  }
+  io_uring_sqe sqe = {};
+  sqe.opcode = opcode;
+  sqe.fd = fd;
+  sqe.addr = reinterpret_cast<std::uintptr_t>(addr);
+  sqe.len = len;
+  sqe.off = off;
+  sqe.msg_flags = flags;
+  sqe.user_data = reinterpret_cast<std::uintptr_t>(static_cast<event_base*>(this));
+  // Threads that run the context submit pending entries the next time they wait for completions.
+  if (const auto ec = context.ring().push(sqe, !context.is_current())) {
+    ec_ = ec;
+    return leave(cancelable, false);
+  }
+  return leave(cancelable, true);
+}
+
+bool event::withdraw(ice::context& context) noexcept {
+  // The operation completes with ECANCELED, which the context replaces with the reason.
+  io_uring_sqe sqe = {};
+  sqe.opcode = IORING_OP_ASYNC_CANCEL;
+  sqe.addr = reinterpret_cast<std::uintptr_t>(static_cast<event_base*>(this));
+  context.ring().push(sqe, !context.is_current());
+  return false;
+}
+
+#elif ICE_OS_LINUX
+
+bool event::ready_recv(ice::context& context, int id) noexcept {
+  if (const auto descriptor = context.descriptors().get(id)) {
+    native_state_ = descriptor->recv_state();
+    return descriptor->ready(native_state_);
   }
   return true;
 }
 
-bool event::queue_send(int context, int id) noexcept {
-  const auto nev = get();
-  native_context_ = context;
-  native_id_ = id;
-  nev->events = EPOLLOUT | EPOLLONESHOT;
-  nev->data.ptr = this;
-  if (::epoll_ctl(context, EPOLL_CTL_ADD, id, nev) < 0) {
-    ec_ = errno;
-    return false;
+bool event::ready_send(ice::context& context, int id) noexcept {
+  if (const auto descriptor = context.descriptors().get(id)) {
+    native_state_ = descriptor->send_state();
+    return descriptor->ready(native_state_);
   }
   return true;
 }
 
-bool event::queue_note(int context, int id) noexcept {
-  const auto nev = get();
-  nev->events = EPOLLOUT | EPOLLONESHOT;
-  nev->data.ptr = this;
-  if (::epoll_ctl(context, EPOLL_CTL_MOD, id, nev) < 0) {
-    ec_ = errno;
-    return false;
+bool event::ready_error(ice::context& context, int id) noexcept {
+  if (const auto descriptor = context.descriptors().get(id)) {
+    native_state_ = descriptor->error_state();
+    return descriptor->ready(native_state_);
   }
   return true;
 }
 
-void event::remove() noexcept {
-  if (native_context_ != -1 && native_id_ != -1) {
-    ::epoll_ctl(native_context_, EPOLL_CTL_DEL, native_id_, get());
-    native_context_ = -1;
-    native_id_ = -1;
+void event::drained_recv(ice::context& context, int id) noexcept {
+  if (const auto descriptor = context.descriptors().get(id)) {
+    descriptor->drain_recv(native_state_);
+  }
+}
+
+bool event::queue_recv(ice::context& context, int id) noexcept {
+  const auto descriptor = context.descriptors().get(id);
+  if (!descriptor) {
+    ec_ = ENOMEM;
+    return false;
+  }
+  native_descriptor_ = descriptor;
+  const auto cancelable = enter(context);
+  while (!descriptor->queue_recv(context.handle(), this, native_state_, ec_)) {
+    if (ec_) {
+      return leave(cancelable, false);
+    }
+    native_state_ = descriptor->recv_state();
+    if (resume()) {
+      return leave(cancelable, false);
+    }
+  }
+  return leave(cancelable, true);
+}
+
+bool event::queue_send(ice::context& context, int id) noexcept {
+  const auto descriptor = context.descriptors().get(id);
+  if (!descriptor) {
+    ec_ = ENOMEM;
+    return false;
+  }
+  native_descriptor_ = descriptor;
+  const auto cancelable = enter(context);
+  while (!descriptor->queue_send(context.handle(), this, native_state_, ec_)) {
+    if (ec_) {
+      return leave(cancelable, false);
+    }
+    native_state_ = descriptor->send_state();
+    if (resume()) {
+      return leave(cancelable, false);
+    }
   }
+  return leave(cancelable, true);
+}
+
+bool event::queue_error(ice::context& context, int id) noexcept {
+  const auto descriptor = context.descriptors().get(id);
+  if (!descriptor) {
+    ec_ = ENOMEM;
+    return false;
+  }
+  native_descriptor_ = descriptor;
+  const auto cancelable = enter(context);
+  while (!descriptor->queue_error(context.handle(), this, native_state_, ec_)) {
+    if (ec_) {
+      return leave(cancelable, false);
+    }
+    native_state_ = descriptor->error_state();
+    if (resume()) {
+      return leave(cancelable, false);
+    }
+  }
+  return leave(cancelable, true);
+}
+
+bool event::withdraw(ice::context& context) noexcept {
+  return native_descriptor_->cancel(context.handle(), this);
 }
 
 #elif ICE_OS_FREEBSD
 
-bool event::queue_recv(int context, int id) noexcept {
+bool event::queue_recv(ice::context& context, int id) noexcept {
   const auto nev = get();
   EV_SET(nev, static_cast<uintptr_t>(id), EVFILT_READ, EV_ADD | EV_ONESHOT, 0, 0, this);
-  if (::kevent(context, nev, 1, nullptr, 0, nullptr) < 0) {
+  const auto cancelable = enter(context);
+  if (::kevent(context.handle(), nev, 1, nullptr, 0, nullptr) < 0) {
     ec_ = errno;
-    return false;
+    return leave(cancelable, false);
   }
-  return true;
+  return leave(cancelable, true);
 }
 
-bool event::queue_send(int context, int id) noexcept {
+bool event::queue_send(ice::context& context, int id) noexcept {
   const auto nev = get();
   EV_SET(nev, static_cast<uintptr_t>(id), EVFILT_WRITE, EV_ADD | EV_ONESHOT, 0, 0, this);
-  if (::kevent(context, nev, 1, nullptr, 0, nullptr) < 0) {
+  const auto cancelable = enter(context);
+  if (::kevent(context.handle(), nev, 1, nullptr, 0, nullptr) < 0) {
     ec_ = errno;
-    return false;
+    return leave(cancelable, false);
   }
-  return true;
+  return leave(cancelable, true);
 }
 
-bool event::queue_note(int context, int id) noexcept {
-  const auto nev = get();
-  EV_SET(nev, static_cast<uintptr_t>(id), EVFILT_USER, EV_ADD | EV_ONESHOT, NOTE_TRIGGER, 0, this);
-  if (::kevent(context, nev, 1, nullptr, 0, nullptr) < 0) {
-    ec_ = errno;
-    return false;
-  }
-  return true;
+bool event::withdraw(ice::context& context) noexcept {
+  // Deleting the one-shot filter fails when it was already retrieved by a thread that runs the context.
+  struct kevent nev = *get();
+  nev.flags = EV_DELETE;
+  return ::kevent(context.handle(), &nev, 1, nullptr, 0, nullptr) == 0;
 }
 
 #endif
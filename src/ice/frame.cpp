@@ -0,0 +1,212 @@
+#include <ice/frame.h>
+#include <ice/utility.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace ice {
+namespace detail {
+namespace {
+
+constexpr std::size_t frame_classes = frame_allocator::max_size / frame_allocator::granularity;
+
+// Returns the size class of a frame. Classes hold frames of up to (index + 1) * granularity bytes.
+constexpr std::size_t frame_class(std::size_t size) noexcept {
+  return (size + frame_allocator::granularity - 1) / frame_allocator::granularity - 1;
+}
+
+constexpr std::size_t frame_class_size(std::size_t index) noexcept {
+  return (index + 1) * frame_allocator::granularity;
+}
+
+struct frame_block {
+  frame_block* next;
+};
+
+class frame_cache;
+
+// Set while the cache of the thread exists. Frames that are released during thread exit after the cache was destroyed
+// go to the heap.
+thread_local bool g_cache_alive = false;
+thread_local bool g_cache_created = false;
+
+// Caches of running threads and the counters of threads that exited.
+// Never destroyed, because threads may release frames after static objects were destroyed.
+struct frame_registry {
+  std::mutex mutex;
+  std::vector<frame_cache*> caches;
+  frame_allocator::counters retired;
+};
+
+frame_registry& registry() {
+  static const auto registry = new frame_registry;
+  return *registry;
+}
+
+// Free lists and counters of a thread. Only that thread writes them, other threads take snapshots of the counters.
+class frame_cache {
+public:
+  frame_cache() {
+    auto& registry = detail::registry();
+    std::lock_guard lock(registry.mutex);
+    registry.caches.push_back(this);
+    g_cache_alive = true;
+  }
+
+  frame_cache(frame_cache&& other) = delete;
+  frame_cache& operator=(frame_cache&& other) = delete;
+
+  frame_cache(const frame_cache& other) = delete;
+  frame_cache& operator=(const frame_cache& other) = delete;
+
+  ~frame_cache();
+
+  void* allocate(std::size_t index) noexcept {
+    auto& list = lists_[index];
+    if (const auto block = list) {
+      list = block->next;
+      sizes_[index]--;
+      cached.store(cached.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+      increment(reused, 1);
+      return block;
+    }
+    return nullptr;
+  }
+
+  bool deallocate(void* data, std::size_t index) noexcept {
+    if (sizes_[index] == frame_allocator::cache_size) {
+      return false;
+    }
+    const auto block = static_cast<frame_block*>(data);
+    block->next = lists_[index];
+    lists_[index] = block;
+    sizes_[index]++;
+    increment(cached, 1);
+    return true;
+  }
+
+  frame_allocator::counters get() const noexcept {
+    frame_allocator::counters result;
+    result.allocations = allocations.load(std::memory_order_relaxed);
+    result.reused = reused.load(std::memory_order_relaxed);
+    result.large = large.load(std::memory_order_relaxed);
+    result.deallocations = deallocations.load(std::memory_order_relaxed);
+    result.cached = cached.load(std::memory_order_relaxed);
+    return result;
+  }
+
+  // Avoids locked instructions, because there is only one writer.
+  static void increment(std::atomic_uint64_t& counter, std::uint64_t value) noexcept {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+  }
+
+  std::atomic_uint64_t allocations = 0;
+  std::atomic_uint64_t reused = 0;
+  std::atomic_uint64_t large = 0;
+  std::atomic_uint64_t deallocations = 0;
+  std::atomic_uint64_t cached = 0;
+
+private:
+  std::array<frame_block*, frame_classes> lists_ = {};
+  std::array<std::size_t, frame_classes> sizes_ = {};
+};
+
+frame_cache::~frame_cache() {
+  g_cache_alive = false;
+  for (std::size_t i = 0; i < lists_.size(); i++) {
+    for (auto block = lists_[i]; block;) {
+      const auto next = block->next;
+      ::operator delete(block, frame_class_size(i));
+      block = next;
+    }
+  }
+  cached.store(0, std::memory_order_relaxed);
+  auto& registry = detail::registry();
+  std::lock_guard lock(registry.mutex);
+  const auto counters = get();
+  registry.retired.allocations += counters.allocations;
+  registry.retired.reused += counters.reused;
+  registry.retired.large += counters.large;
+  registry.retired.deallocations += counters.deallocations;
+  registry.caches.erase(std::remove(registry.caches.begin(), registry.caches.end(), this), registry.caches.end());
+}
+
+frame_cache& cache() {
+  thread_local frame_cache cache;
+  return cache;
+}
+
+// Returns the cache of the calling thread or nullptr when it could not be created or was already destroyed.
+frame_cache* current() noexcept {
+  if (ICE_LIKELY(g_cache_alive)) {
+    return &cache();
+  }
+  if (g_cache_created) {
+    return nullptr;
+  }
+  g_cache_created = true;
+  try {
+    return &cache();
+  }
+  catch (...) {
+    return nullptr;
+  }
+}
+
+}  // namespace
+}  // namespace detail
+
+void* frame_allocator::allocate(std::size_t size) {
+  const auto cache = detail::current();
+  if (cache) {
+    detail::frame_cache::increment(cache->allocations, 1);
+  }
+  if (size > max_size) {
+    if (cache) {
+      detail::frame_cache::increment(cache->large, 1);
+    }
+    return ::operator new(size);
+  }
+  const auto index = detail::frame_class(size);
+  if (cache) {
+    if (const auto data = cache->allocate(index)) {
+      return data;
+    }
+  }
+  return ::operator new(detail::frame_class_size(index));
+}
+
+void frame_allocator::deallocate(void* data, std::size_t size) noexcept {
+  const auto cache = detail::current();
+  if (cache) {
+    detail::frame_cache::increment(cache->deallocations, 1);
+  }
+  if (size > max_size) {
+    ::operator delete(data, size);
+    return;
+  }
+  const auto index = detail::frame_class(size);
+  if (!cache || !cache->deallocate(data, index)) {
+    ::operator delete(data, detail::frame_class_size(index));
+  }
+}
+
+frame_allocator::counters frame_allocator::statistics() {
+  auto& registry = detail::registry();
+  std::lock_guard lock(registry.mutex);
+  auto result = registry.retired;
+  for (const auto cache : registry.caches) {
+    const auto counters = cache->get();
+    result.allocations += counters.allocations;
+    result.reused += counters.reused;
+    result.large += counters.large;
+    result.deallocations += counters.deallocations;
+    result.cached += counters.cached;
+  }
+  return result;
+}
+
+}  // namespace ice
@@ -0,0 +1,154 @@
+#include <ice/group.h>
+#include <algorithm>
+#include <utility>
+
+#if ICE_OS_WIN32
+#  include <windows.h>
+#elif ICE_OS_LINUX
+#  include <pthread.h>
+#  include <sched.h>
+#elif ICE_OS_FREEBSD
+#  include <sys/param.h>
+#  include <sys/cpuset.h>
+#  include <pthread.h>
+#  include <pthread_np.h>
+#endif
+
+namespace ice {
+namespace detail {
+namespace {
+
+// Returns the processors the process may run on.
+std::vector<unsigned> processors() {
+  std::vector<unsigned> result;
+#if ICE_OS_WIN32
+  DWORD_PTR process = 0;
+  DWORD_PTR system = 0;
+  if (::GetProcessAffinityMask(::GetCurrentProcess(), &process, &system)) {
+    for (unsigned i = 0; i < sizeof(process) * 8; i++) {
+      if (process & (DWORD_PTR(1) << i)) {
+        result.push_back(i);
+      }
+    }
+  }
+#elif ICE_OS_LINUX
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (::sched_getaffinity(0, sizeof(set), &set) == 0) {
+    for (unsigned i = 0; i < CPU_SETSIZE; i++) {
+      if (CPU_ISSET(i, &set)) {
+        result.push_back(i);
+      }
+    }
+  }
+#elif ICE_OS_FREEBSD
+  cpuset_t set;
+  CPU_ZERO(&set);
+  if (::cpuset_getaffinity(CPU_LEVEL_WHICH, CPU_WHICH_PID, -1, sizeof(set), &set) == 0) {
+    for (unsigned i = 0; i < CPU_SETSIZE; i++) {
+      if (CPU_ISSET(i, &set)) {
+        result.push_back(i);
+      }
+    }
+  }
+#endif
+  if (result.empty()) {
+    result.resize(std::max(std::thread::hardware_concurrency(), 1u));
+    for (unsigned i = 0; i < result.size(); i++) {
+      result[i] = i;
+    }
+  }
+  return result;
+}
+
+// Pins the calling thread to a processor. Failures are ignored, because the thread can still run unpinned.
+void pin(unsigned processor) noexcept {
+#if ICE_OS_WIN32
+  if (processor < sizeof(DWORD_PTR) * 8) {
+    ::SetThreadAffinityMask(::GetCurrentThread(), DWORD_PTR(1) << processor);
+  }
+#elif ICE_OS_LINUX
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(processor, &set);
+  ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set);
+#elif ICE_OS_FREEBSD
+  cpuset_t set;
+  CPU_ZERO(&set);
+  CPU_SET(processor, &set);
+  ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set);
+#endif
+}
+
+}  // namespace
+}  // namespace detail
+
+context_group::context_group(std::size_t size, ice::context::trigger mode) : processors_(detail::processors()) {
+  if (!size) {
+    size = processors_.size();
+  }
+  contexts_.reserve(size);
+  for (std::size_t i = 0; i < size; i++) {
+    contexts_.push_back(std::make_unique<ice::context>(mode));
+  }
+}
+
+context_group::~context_group() {
+  stop();
+  for (auto& thread : threads_) {
+    if (thread.joinable()) {
+      thread.join();
+    }
+  }
+}
+
+ice::context* context_group::current() noexcept {
+  for (auto& context : contexts_) {
+    if (context->is_current()) {
+      return context.get();
+    }
+  }
+  return nullptr;
+}
+
+ice::context& context_group::next() noexcept {
+  return *contexts_[next_.fetch_add(1, std::memory_order_relaxed) % contexts_.size()];
+}
+
+void context_group::start(std::size_t event_buffer_size) {
+  errors_.resize(contexts_.size());
+  threads_.reserve(contexts_.size());
+  for (std::size_t i = threads_.size(); i < contexts_.size(); i++) {
+    threads_.emplace_back([this, i, event_buffer_size]() {
+      detail::pin(processors_[i % processors_.size()]);
+      try {
+        contexts_[i]->run(event_buffer_size);
+      }
+      catch (...) {
+        errors_[i] = std::current_exception();
+        stop();
+      }
+    });
+  }
+}
+
+void context_group::stop() noexcept {
+  for (auto& context : contexts_) {
+    context->stop();
+  }
+}
+
+void context_group::join() {
+  for (auto& thread : threads_) {
+    if (thread.joinable()) {
+      thread.join();
+    }
+  }
+  for (auto& error : errors_) {
+    if (error) {
+      std::rethrow_exception(std::exchange(error, nullptr));
+    }
+  }
+}
+
+}  // namespace ice
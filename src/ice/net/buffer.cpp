@@ -6,6 +6,10 @@
 #  include <winsock2.h>
 #  include <type_traits>
 #  include <cstddef>
+#else
+#  include <sys/uio.h>
+#  include <type_traits>
+#  include <cstddef>
 #endif
 
 namespace ice::net {
@@ -34,6 +38,23 @@ static_assert(ICE_OFFSETOF(buffer, size) == ICE_OFFSETOF(WSABUF, len));
 // Verify data offset.
 static_assert(ICE_OFFSETOF(buffer, data) == ICE_OFFSETOF(WSABUF, buf));
 
+#else
+
+// Verify size.
+static_assert(sizeof(buffer) == sizeof(::iovec));
+
+// Verify alignment.
+static_assert(alignof(buffer) == alignof(::iovec));
+
+// Verify size type.
+static_assert(std::is_same_v<decltype(buffer::size), decltype(::iovec::iov_len)>);
+
+// Verify size offset.
+static_assert(offsetof(buffer, size) == offsetof(::iovec, iov_len));
+
+// Verify data offset.
+static_assert(offsetof(buffer, data) == offsetof(::iovec, iov_base));
+
 #endif
 
 }  // namespace ice::net
@@ -19,12 +19,13 @@ endpoint::endpoint() noexcept {
   new (&storage_) sockaddr_storage;
 }
 
-endpoint::endpoint(const endpoint& other) noexcept {
+endpoint::endpoint(const endpoint& other) noexcept : size_(other.size_) {
   new (static_cast<void*>(&storage_)) sockaddr_storage{ reinterpret_cast<const sockaddr_storage&>(other.storage_) };
 }
 
 endpoint& endpoint::operator=(const endpoint& other) noexcept {
   reinterpret_cast<sockaddr_storage&>(storage_) = reinterpret_cast<const sockaddr_storage&>(other.storage_);
+  size_ = other.size_;
   return *this;
 }
 
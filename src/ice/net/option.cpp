@@ -104,4 +104,21 @@ int option::reuse_address::name() const noexcept {
   return SO_REUSEADDR;
 }
 
+int option::reuse_port::name() const noexcept {
+#if ICE_OS_WIN32
+  // Windows has no option that distributes connections between sockets sharing an address.
+  return -1;
+#else
+  return SO_REUSEPORT;
+#endif
+}
+
+int option::busy_poll::name() const noexcept {
+#if ICE_OS_LINUX
+  return SO_BUSY_POLL;
+#else
+  return -1;
+#endif
+}
+
 }  // namespace ice::net
@@ -45,6 +45,7 @@ socket::socket(ice::context& context, int family, int type, int protocol) : cont
   if (!handle_) {
     throw ice::system_error(errno, "create socket");
   }
+  context.attach(handle_);
 #endif
 }
 
@@ -0,0 +1,124 @@
+#include <ice/net/stream.h>
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace ice::net {
+namespace {
+
+// Returns the position of the delimiter in the data starting at the given offset.
+std::size_t find(std::string_view data, std::string_view delimiter, std::size_t offset) noexcept {
+  if (data.size() < delimiter.size() || data.size() - delimiter.size() < offset) {
+    return std::string_view::npos;
+  }
+  const auto first = delimiter.front();
+  const auto rest = delimiter.substr(1);
+  auto pos = data.data() + offset;
+  const auto end = data.data() + (data.size() - delimiter.size()) + 1;
+  while (pos < end) {
+    pos = static_cast<const char*>(std::memchr(pos, first, static_cast<std::size_t>(end - pos)));
+    if (!pos) {
+      break;
+    }
+    if (std::memcmp(pos + 1, rest.data(), rest.size()) == 0) {
+      return static_cast<std::size_t>(pos - data.data());
+    }
+    pos++;
+  }
+  return std::string_view::npos;
+}
+
+}  // namespace
+
+stream::stream(tcp::socket& socket, std::size_t capacity, std::size_t limit) :
+  socket_(socket), data_(new char[capacity]), capacity_(capacity), limit_(limit) {
+  assert(capacity > 0 && capacity <= limit);
+}
+
+ice::async<std::string_view> stream::read_some() {
+  if (begin_ == end_) {
+    reserve(1);
+    const auto received = co_await recv();
+    if (!commit(received)) {
+      co_return std::string_view{};
+    }
+  }
+  co_return take(end_ - begin_);
+}
+
+ice::async<std::string_view> stream::read_exact(std::size_t size) {
+  while (end_ - begin_ < size) {
+    reserve(size);
+    const auto received = co_await recv();
+    if (!commit(received)) {
+      co_return take(end_ - begin_);
+    }
+  }
+  co_return take(size);
+}
+
+ice::async<std::string_view> stream::read_until(std::string_view delimiter) {
+  assert(!delimiter.empty());
+  // Buffered data in front of this offset was searched already.
+  std::size_t offset = 0;
+  while (true) {
+    const auto data = buffered();
+    if (const auto pos = find(data, delimiter, offset); pos != std::string_view::npos) {
+      co_return take(pos + delimiter.size());
+    }
+    if (data.size() >= delimiter.size()) {
+      offset = data.size() - delimiter.size() + 1;
+    }
+    reserve(data.size() + 1);
+    const auto received = co_await recv();
+    if (!commit(received)) {
+      co_return take(end_ - begin_);
+    }
+  }
+}
+
+void stream::reserve(std::size_t size) {
+  const auto used = end_ - begin_;
+  assert(size > used);
+  if (size > limit_) {
+    throw ice::system_error(ice::error_code(std::errc::message_size), "stream buffer limit");
+  }
+  if (end_ < capacity_ && capacity_ - begin_ >= size) {
+    return;
+  }
+  if (capacity_ >= size) {
+    std::memmove(data_.get(), data_.get() + begin_, used);
+  } else {
+    const auto capacity = std::min(std::max(capacity_ * 2, size), limit_);
+    std::unique_ptr<char[]> data(new char[capacity]);
+    std::memcpy(data.get(), data_.get() + begin_, used);
+    data_ = std::move(data);
+    capacity_ = capacity;
+  }
+  begin_ = 0;
+  end_ = used;
+}
+
+tcp::recv stream::recv() noexcept {
+  assert(end_ < capacity_);
+  return socket_.recv(data_.get() + end_, capacity_ - end_);
+}
+
+bool stream::commit(std::size_t size) noexcept {
+  end_ += size;
+  return size > 0;
+}
+
+std::string_view stream::take(std::size_t size) noexcept {
+  assert(size <= end_ - begin_);
+  const std::string_view data{ data_.get() + begin_, size };
+  begin_ += size;
+  // Consuming all data frees the whole buffer without moving anything.
+  if (begin_ == end_) {
+    begin_ = 0;
+    end_ = 0;
+  }
+  return data;
+}
+
+}  // namespace ice::net
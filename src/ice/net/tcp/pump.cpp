@@ -0,0 +1,248 @@
+#include <ice/net/tcp/pump.h>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <cassert>
+
+#if ICE_OS_LINUX
+#  include <fcntl.h>
+#  include <unistd.h>
+#endif
+
+#if ICE_IO_URING
+#  include <linux/io_uring.h>
+#endif
+
+namespace ice::net::tcp {
+namespace detail {
+
+// Size of the buffers that pumps copy through.
+constexpr std::size_t pump_buffer_size = 64 * 1024;
+
+// Maximum number of buffers kept for later pumps.
+constexpr std::size_t pump_buffer_cache_size = 64;
+
+// Buffer that is taken from the pool when created and returned to it when destroyed.
+class pump_buffer {
+public:
+  pump_buffer() {
+    {
+      std::lock_guard lock(mutex_);
+      if (!cache_.empty()) {
+        data_ = std::move(cache_.back());
+        cache_.pop_back();
+        return;
+      }
+    }
+    data_ = std::make_unique<char[]>(pump_buffer_size);
+  }
+
+  pump_buffer(pump_buffer&& other) = delete;
+  pump_buffer& operator=(pump_buffer&& other) = delete;
+
+  pump_buffer(const pump_buffer& other) = delete;
+  pump_buffer& operator=(const pump_buffer& other) = delete;
+
+  ~pump_buffer() {
+    std::lock_guard lock(mutex_);
+    if (cache_.size() < pump_buffer_cache_size) {
+      cache_.push_back(std::move(data_));
+    }
+  }
+
+  char* data() noexcept {
+    return data_.get();
+  }
+
+private:
+  static std::mutex mutex_;
+  static std::vector<std::unique_ptr<char[]>> cache_;
+  std::unique_ptr<char[]> data_;
+};
+
+std::mutex pump_buffer::mutex_;
+std::vector<std::unique_ptr<char[]>> pump_buffer::cache_;
+
+#if ICE_OS_LINUX
+
+// Non-blocking pipe that the data is spliced through.
+class pipe {
+public:
+  pipe() noexcept {
+    int fds[2] = { -1, -1 };
+    if (::pipe2(fds, O_NONBLOCK | O_CLOEXEC) == 0) {
+      recv_ = fds[0];
+      send_ = fds[1];
+    }
+  }
+
+  pipe(pipe&& other) = delete;
+  pipe& operator=(pipe&& other) = delete;
+
+  pipe(const pipe& other) = delete;
+  pipe& operator=(const pipe& other) = delete;
+
+  ~pipe() {
+    if (recv_ != -1) {
+      ::close(recv_);
+      ::close(send_);
+    }
+  }
+
+  constexpr explicit operator bool() const noexcept {
+    return recv_ != -1;
+  }
+
+  constexpr int recv() const noexcept {
+    return recv_;
+  }
+
+  constexpr int send() const noexcept {
+    return send_;
+  }
+
+private:
+  int recv_ = -1;
+  int send_ = -1;
+};
+
+// Moves the data that is available on the socket into the pipe. Completes with 0 on EOF.
+class splice_recv final : public ice::event {
+public:
+  splice_recv(tcp::socket& socket, detail::pipe& pipe) noexcept :
+    context_(socket.context()), socket_(socket.handle()), pipe_(pipe.send()) {
+  }
+
+  bool await_ready() noexcept {
+    if (!ready_recv(context_, socket_)) {
+      return false;
+    }
+    constexpr auto flags = SPLICE_F_MOVE | SPLICE_F_NONBLOCK;
+    if (const auto rc = ::splice(socket_, nullptr, pipe_, nullptr, pump_buffer_size, flags); rc >= 0) {
+      size_ = static_cast<std::size_t>(rc);
+      return true;
+    }
+    if (errno == ECONNRESET) {
+      size_ = 0;
+      return true;
+    }
+    if (errno != EAGAIN && errno != EINTR) {
+      ec_ = errno;
+      return true;
+    }
+    return false;
+  }
+
+  bool suspend() noexcept override {
+    return queue_recv(context_, socket_);
+  }
+
+  bool resume() noexcept override {
+#  if ICE_IO_URING
+    if (const auto rc = get()->res; rc < 0) {
+      ec_ = -rc;
+      return true;
+    }
+#  endif
+    return await_ready();
+  }
+
+  std::size_t await_resume() {
+    if (ec_) {
+      throw ice::system_error(ec_, "tcp pump recv");
+    }
+    return size_;
+  }
+
+private:
+  ice::context& context_;
+  net::socket::handle_view socket_;
+  const int pipe_;
+  std::size_t size_ = 0;
+};
+
+// Moves the given number of bytes from the pipe to the socket.
+class splice_send final : public ice::event {
+public:
+  splice_send(tcp::socket& socket, detail::pipe& pipe, std::size_t size) noexcept :
+    context_(socket.context()), socket_(socket.handle()), pipe_(pipe.recv()), size_(size) {
+  }
+
+  bool await_ready() noexcept {
+    if (!ready_send(context_, socket_)) {
+      return false;
+    }
+    constexpr auto flags = SPLICE_F_MOVE | SPLICE_F_NONBLOCK;
+    while (size_ > 0) {
+      if (const auto rc = ::splice(pipe_, nullptr, socket_, nullptr, size_, flags); rc > 0) {
+        assert(size_ >= static_cast<std::size_t>(rc));
+        size_ -= static_cast<std::size_t>(rc);
+        continue;
+      } else if (rc == 0) {
+        break;
+      }
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno != EAGAIN) {
+        ec_ = errno;
+        break;
+      }
+      return false;
+    }
+    return true;
+  }
+
+  bool suspend() noexcept override {
+    return queue_send(context_, socket_);
+  }
+
+  bool resume() noexcept override {
+#  if ICE_IO_URING
+    if (const auto rc = get()->res; rc < 0) {
+      ec_ = -rc;
+      return true;
+    }
+#  endif
+    return await_ready();
+  }
+
+  void await_resume() {
+    if (ec_) {
+      throw ice::system_error(ec_, "tcp pump send");
+    }
+  }
+
+private:
+  ice::context& context_;
+  net::socket::handle_view socket_;
+  const int pipe_;
+  std::size_t size_;
+};
+
+#endif
+
+}  // namespace detail
+
+ice::async<std::size_t> pump(tcp::socket& from, tcp::socket& to) {
+  std::size_t size = 0;
+#if ICE_OS_LINUX
+  if (detail::pipe pipe; pipe) {
+    while (const auto received = co_await detail::splice_recv(from, pipe)) {
+      co_await detail::splice_send(to, pipe, received);
+      size += received;
+    }
+    to.shutdown(net::shutdown::send);
+    co_return size;
+  }
+#endif
+  detail::pump_buffer buffer;
+  while (const auto received = co_await from.recv(buffer.data(), detail::pump_buffer_size)) {
+    co_await to.send(buffer.data(), received);
+    size += received;
+  }
+  to.shutdown(net::shutdown::send);
+  co_return size;
+}
+
+}  // namespace ice::net::tcp
@@ -1,4 +1,5 @@
 #include <ice/net/tcp/socket.h>
+#include <algorithm>
 #include <cassert>
 
 #if ICE_OS_WIN32
@@ -10,8 +11,20 @@
 #else
 #  include <sys/types.h>
 #  include <sys/socket.h>
+#  include <sys/uio.h>
 #  include <netinet/in.h>
 #  include <unistd.h>
+#  include <climits>
+#endif
+
+#if ICE_OS_LINUX
+#  include <sys/sendfile.h>
+#  include <linux/errqueue.h>
+#  include <cstring>
+#endif
+
+#if ICE_IO_URING
+#  include <linux/io_uring.h>
 #endif
 
 namespace ice::net::tcp {
@@ -45,6 +58,23 @@ struct connect_ex {
   LPFN_CONNECTEX function = nullptr;
 };
 
+#else
+
+// Returns the number of buffers that can be passed to a single vectored system call.
+inline int iov_count(std::size_t count) noexcept {
+  return static_cast<int>(std::min<std::size_t>(count, IOV_MAX));
+}
+
+// Returns the size of the given buffers.
+template <typename T>
+inline std::size_t iov_size(const net::basic_buffer<T>* buffers, int count) noexcept {
+  std::size_t size = 0;
+  for (int i = 0; i < count; i++) {
+    size += buffers[i].size;
+  }
+  return size;
+}
+
 #endif
 
 }  // namespace detail
@@ -72,13 +102,34 @@ void socket::listen(std::size_t backlog) {
 #endif
 }
 
+std::vector<tcp::socket> listen(ice::context_group& group, const net::endpoint& endpoint, std::size_t backlog) {
+  std::vector<tcp::socket> sockets;
+  sockets.reserve(group.size());
+  for (std::size_t i = 0; i < group.size(); i++) {
+    auto& socket = sockets.emplace_back(group[i], endpoint.family());
+    socket.set(net::option::reuse_address(true));
+    if (group.size() > 1) {
+      if (const auto ec = socket.set(net::option::reuse_port(true))) {
+        throw ice::system_error(ec, "set reuse port socket option");
+      }
+    }
+    socket.bind(endpoint);
+    socket.listen(backlog);
+  }
+  return sockets;
+}
+
 bool accept::await_ready() noexcept {
 #if ICE_OS_LINUX || ICE_OS_FREEBSD
+  if (!ready_recv(context_, socket_)) {
+    return false;
+  }
   client_.endpoint().size() = client_.endpoint().capacity();
   auto& sockaddr = client_.endpoint().sockaddr();
   auto& size = client_.endpoint().size();
   client_.handle().reset(::accept4(socket_, &sockaddr, &size, SOCK_NONBLOCK));
   if (client_) {
+    context_.attach(client_.handle());
     return true;
   }
   if (errno != EAGAIN && errno != EINTR) {
@@ -90,23 +141,34 @@ bool accept::await_ready() noexcept {
 }
 
 bool accept::suspend() noexcept {
+  timeout_.start(context_);
+  registration_.start();
 #if ICE_OS_WIN32
   const auto socket = socket_.as<SOCKET>();
   const auto client = client_.handle().as<SOCKET>();
+  const auto cancelable = enter(socket_);
   while (true) {
     if (::AcceptEx(socket, client, &buffer_, 0, buffer_size, buffer_size, &bytes_, get())) {
       break;
     }
     const auto rc = ::WSAGetLastError();
     if (rc == ERROR_IO_PENDING) {
+      leave(cancelable);
       return true;
     }
     if (rc != WSAECONNRESET) {
       ec_ = rc;
-      return false;
+      break;
     }
   }
+  leave(cancelable);
   return false;
+#elif ICE_IO_URING
+  auto& sockaddr = client_.endpoint().sockaddr();
+  auto& size = client_.endpoint().size();
+  size = client_.endpoint().capacity();
+  const auto addr2 = reinterpret_cast<std::uintptr_t>(&size);
+  return queue(context_, IORING_OP_ACCEPT, socket_, &sockaddr, 0, addr2, SOCK_NONBLOCK);
 #else
   return queue_recv(context_, socket_);
 #endif
@@ -134,13 +196,39 @@ bool accept::resume() noexcept {
     break;
   }
   return true;
+#elif ICE_IO_URING
+  if (const auto rc = get()->res; rc >= 0) {
+    client_.handle().reset(rc);
+    context_.attach(rc);
+    return true;
+  } else if (rc != -EAGAIN && rc != -EINTR && rc != -ECONNABORTED) {
+    ec_ = -rc;
+    return true;
+  }
+  return false;
 #else
   return await_ready();
 #endif
 }
 
 connect::connect(tcp::socket& socket, const net::endpoint& endpoint) noexcept :
-  context_(socket.context().handle()), socket_(socket.handle()), endpoint_(endpoint) {
+  context_(socket.context()), socket_(socket.handle()), endpoint_(endpoint) {
+  prepare(socket);
+}
+
+connect::connect(tcp::socket& socket, const net::endpoint& endpoint, ice::context::clock::duration timeout) noexcept :
+  context_(socket.context()), socket_(socket.handle()), endpoint_(endpoint), timeout_(*this, timeout) {
+  cancelable();
+  prepare(socket);
+}
+
+connect::connect(tcp::socket& socket, const net::endpoint& endpoint, ice::cancellation_token token) noexcept :
+  context_(socket.context()), socket_(socket.handle()), endpoint_(endpoint), registration_(*this, std::move(token)) {
+  cancelable();
+  prepare(socket);
+}
+
+void connect::prepare(tcp::socket& socket) noexcept {
 #if ICE_OS_WIN32
   sockaddr_in addr = {};
   addr.sin_family = AF_INET;
@@ -150,11 +238,11 @@ connect::connect(tcp::socket& socket, const net::endpoint& endpoint) noexcept :
     ec_ = ::WSAGetLastError();
   }
 #endif
-  socket.endpoint() = endpoint;
+  socket.endpoint() = endpoint_;
 }
 
 bool connect::await_ready() noexcept {
-#if ICE_OS_LINUX || ICE_OS_FREEBSD
+#if (ICE_OS_LINUX && !ICE_IO_URING) || ICE_OS_FREEBSD
   while (true) {
     if (::connect(socket_, &endpoint_.sockaddr(), endpoint_.size()) == 0) {
       return true;
@@ -177,6 +265,8 @@ bool connect::await_ready() noexcept {
 }
 
 bool connect::suspend() noexcept {
+  timeout_.start(context_);
+  registration_.start();
 #if ICE_OS_WIN32
   static const detail::connect_ex connect;
   if (connect.ec) {
@@ -184,14 +274,20 @@ bool connect::suspend() noexcept {
     return false;
   }
   const auto socket = socket_.as<SOCKET>();
+  const auto cancelable = enter(socket_);
   if (connect(socket, &endpoint_.sockaddr(), endpoint_.size(), nullptr, 0, nullptr, get())) {
+    leave(cancelable);
     return false;
   }
   if (const auto rc = ::WSAGetLastError(); rc != ERROR_IO_PENDING) {
     ec_ = rc;
+    leave(cancelable);
     return false;
   }
+  leave(cancelable);
   return true;
+#elif ICE_IO_URING
+  return queue(context_, IORING_OP_CONNECT, socket_, &endpoint_.sockaddr(), 0, endpoint_.size());
 #else
   return queue_send(context_, socket_);
 #endif
@@ -204,6 +300,10 @@ bool connect::resume() noexcept {
   if (!::GetOverlappedResult(socket, get(), &bytes, FALSE)) {
     ec_ = ::GetLastError();
   }
+#elif ICE_IO_URING
+  if (const auto rc = get()->res; rc < 0) {
+    ec_ = -rc;
+  }
 #else
   auto code = 0;
   auto size = static_cast<socklen_t>(sizeof(code));
@@ -218,7 +318,13 @@ bool connect::resume() noexcept {
 
 bool recv::await_ready() noexcept {
 #if ICE_OS_LINUX || ICE_OS_FREEBSD
+  if (!ready_recv(context_, socket_)) {
+    return false;
+  }
   if (const auto rc = ::read(socket_, buffer_.data, buffer_.size); rc >= 0) {
+    if (rc > 0 && static_cast<std::size_t>(rc) < buffer_.size) {
+      drained_recv(context_, socket_);
+    }
     buffer_.size = static_cast<std::size_t>(rc);
     return true;
   }
@@ -235,18 +341,26 @@ bool recv::await_ready() noexcept {
 }
 
 bool recv::suspend() noexcept {
+  timeout_.start(context_);
+  registration_.start();
 #if ICE_OS_WIN32
   const auto socket = socket_.as<SOCKET>();
   const auto buffer = std::launder(reinterpret_cast<LPWSABUF>(&buffer_));
+  const auto cancelable = enter(socket_);
   if (::WSARecv(socket, buffer, 1, &bytes_, &flags_, get(), nullptr) != SOCKET_ERROR) {
     buffer_.size = bytes_;
+    leave(cancelable);
     return false;
   }
   if (const auto rc = ::WSAGetLastError(); rc != ERROR_IO_PENDING) {
     ec_ = rc;
+    leave(cancelable);
     return false;
   }
+  leave(cancelable);
   return true;
+#elif ICE_IO_URING
+  return queue(context_, IORING_OP_RECV, socket_, buffer_.data, static_cast<std::uint32_t>(buffer_.size));
 #else
   return queue_recv(context_, socket_);
 #endif
@@ -260,6 +374,17 @@ bool recv::resume() noexcept {
   }
   buffer_.size = bytes_;
   return true;
+#elif ICE_IO_URING
+  if (const auto rc = get()->res; rc >= 0) {
+    buffer_.size = static_cast<std::size_t>(rc);
+  } else if (rc == -ECONNRESET) {
+    buffer_.size = 0;
+  } else if (rc == -EAGAIN || rc == -EINTR) {
+    return false;
+  } else {
+    ec_ = -rc;
+  }
+  return true;
 #else
   return await_ready();
 #endif
@@ -267,6 +392,9 @@ bool recv::resume() noexcept {
 
 bool send::await_ready() noexcept {
 #if ICE_OS_LINUX || ICE_OS_FREEBSD
+  if (!ready_send(context_, socket_)) {
+    return false;
+  }
   if (const auto rc = ::write(socket_, buffer_.data, buffer_.size); rc > 0) {
     assert(buffer_.size >= static_cast<std::size_t>(rc));
     buffer_.data += static_cast<std::size_t>(rc);
@@ -285,7 +413,10 @@ bool send::await_ready() noexcept {
 }
 
 bool send::suspend() noexcept {
+  timeout_.start(context_);
+  registration_.start();
 #if ICE_OS_WIN32
+  const auto cancelable = enter(socket_);
   while (buffer_.size > 0) {
     const auto socket = socket_.as<SOCKET>();
     const auto buffer = std::launder(reinterpret_cast<LPWSABUF>(&buffer_));
@@ -294,6 +425,7 @@ bool send::suspend() noexcept {
         ec_ = rc;
         break;
       }
+      leave(cancelable);
       return true;
     }
     buffer_.data += bytes_;
@@ -303,7 +435,10 @@ bool send::suspend() noexcept {
       break;
     }
   }
+  leave(cancelable);
   return false;
+#elif ICE_IO_URING
+  return queue(context_, IORING_OP_SEND, socket_, buffer_.data, static_cast<std::uint32_t>(buffer_.size));
 #else
   return queue_send(context_, socket_);
 #endif
@@ -323,6 +458,21 @@ bool send::resume() noexcept {
     }
   }
   return true;
+#elif ICE_IO_URING
+  if (const auto rc = get()->res; rc > 0) {
+    assert(buffer_.size >= static_cast<std::size_t>(rc));
+    buffer_.data += static_cast<std::size_t>(rc);
+    buffer_.size -= static_cast<std::size_t>(rc);
+    size_ += static_cast<std::size_t>(rc);
+    return buffer_.size == 0;
+  } else if (rc == 0) {
+    return true;
+  } else if (rc == -EAGAIN || rc == -EINTR) {
+    return false;
+  } else {
+    ec_ = -rc;
+  }
+  return true;
 #else
   return await_ready();
 #endif
@@ -330,6 +480,9 @@ bool send::resume() noexcept {
 
 bool send_some::await_ready() noexcept {
 #if ICE_OS_LINUX || ICE_OS_FREEBSD
+  if (!ready_send(context_, socket_)) {
+    return false;
+  }
   if (const auto rc = ::write(socket_, buffer_.data, buffer_.size); rc > 0) {
     assert(buffer_.size >= static_cast<std::size_t>(rc));
     buffer_.data += static_cast<std::size_t>(rc);
@@ -348,20 +501,28 @@ bool send_some::await_ready() noexcept {
 }
 
 bool send_some::suspend() noexcept {
+  timeout_.start(context_);
+  registration_.start();
 #if ICE_OS_WIN32
   const auto socket = socket_.as<SOCKET>();
   const auto buffer = std::launder(reinterpret_cast<LPWSABUF>(&buffer_));
+  const auto cancelable = enter(socket_);
   if (::WSASend(socket, buffer, 1, &bytes_, 0, get(), nullptr) == SOCKET_ERROR) {
     if (const auto rc = ::WSAGetLastError(); rc != ERROR_IO_PENDING) {
       ec_ = rc;
+      leave(cancelable);
       return false;
     }
+    leave(cancelable);
     return true;
   }
   buffer_.data += bytes_;
   buffer_.size -= bytes_;
   size_ += bytes_;
+  leave(cancelable);
   return false;
+#elif ICE_IO_URING
+  return queue(context_, IORING_OP_SEND, socket_, buffer_.data, static_cast<std::uint32_t>(buffer_.size));
 #else
   return queue_send(context_, socket_);
 #endif
@@ -378,9 +539,379 @@ bool send_some::resume() noexcept {
     size_ += bytes_;
   }
   return true;
+#elif ICE_IO_URING
+  if (const auto rc = get()->res; rc > 0) {
+    assert(buffer_.size >= static_cast<std::size_t>(rc));
+    buffer_.data += static_cast<std::size_t>(rc);
+    buffer_.size -= static_cast<std::size_t>(rc);
+    size_ += static_cast<std::size_t>(rc);
+  } else if (rc == -EAGAIN || rc == -EINTR) {
+    return false;
+  } else if (rc < 0) {
+    ec_ = -rc;
+  }
+  return true;
+#else
+  return await_ready();
+#endif
+}
+
+bool recv_buffers::await_ready() noexcept {
+#if ICE_OS_LINUX || ICE_OS_FREEBSD
+  if (!ready_recv(context_, socket_)) {
+    return false;
+  }
+  const auto count = detail::iov_count(count_);
+  if (const auto rc = ::readv(socket_, reinterpret_cast<const ::iovec*>(buffers_), count); rc >= 0) {
+    if (rc > 0 && static_cast<std::size_t>(rc) < detail::iov_size(buffers_, count)) {
+      drained_recv(context_, socket_);
+    }
+    size_ = static_cast<std::size_t>(rc);
+    return true;
+  }
+  if (errno == ECONNRESET) {
+    size_ = 0;
+    return true;
+  }
+  if (errno != EAGAIN && errno != EINTR) {
+    ec_ = errno;
+    return true;
+  }
+#endif
+  return false;
+}
+
+bool recv_buffers::suspend() noexcept {
+  timeout_.start(context_);
+  registration_.start();
+#if ICE_OS_WIN32
+  const auto socket = socket_.as<SOCKET>();
+  const auto buffers = std::launder(reinterpret_cast<LPWSABUF>(const_cast<net::buffer*>(buffers_)));
+  const auto count = static_cast<DWORD>(count_);
+  const auto cancelable = enter(socket_);
+  if (::WSARecv(socket, buffers, count, &bytes_, &flags_, get(), nullptr) != SOCKET_ERROR) {
+    size_ = bytes_;
+    leave(cancelable);
+    return false;
+  }
+  if (const auto rc = ::WSAGetLastError(); rc != ERROR_IO_PENDING) {
+    ec_ = rc;
+    leave(cancelable);
+    return false;
+  }
+  leave(cancelable);
+  return true;
+#elif ICE_IO_URING
+  const auto count = static_cast<std::uint32_t>(detail::iov_count(count_));
+  return queue(context_, IORING_OP_READV, socket_, buffers_, count);
+#else
+  return queue_recv(context_, socket_);
+#endif
+}
+
+bool recv_buffers::resume() noexcept {
+#if ICE_OS_WIN32
+  const auto socket = socket_.as<HANDLE>();
+  if (!::GetOverlappedResult(socket, get(), &bytes_, FALSE)) {
+    ec_ = ::GetLastError();
+  }
+  size_ = bytes_;
+  return true;
+#elif ICE_IO_URING
+  if (const auto rc = get()->res; rc >= 0) {
+    size_ = static_cast<std::size_t>(rc);
+  } else if (rc == -ECONNRESET) {
+    size_ = 0;
+  } else if (rc == -EAGAIN || rc == -EINTR) {
+    return false;
+  } else {
+    ec_ = -rc;
+  }
+  return true;
+#else
+  return await_ready();
+#endif
+}
+
+bool send_buffers::advance(std::size_t size) noexcept {
+  size_ += size;
+  while (count_ > 0 && size >= buffers_->size) {
+    size -= buffers_->size;
+    buffers_++;
+    count_--;
+  }
+  if (count_ > 0) {
+    buffers_->data += size;
+    buffers_->size -= static_cast<net::const_buffer::size_type>(size);
+  }
+  return count_ == 0;
+}
+
+bool send_buffers::await_ready() noexcept {
+  if (advance(0)) {
+    return true;
+  }
+#if ICE_OS_LINUX || ICE_OS_FREEBSD
+  if (!ready_send(context_, socket_)) {
+    return false;
+  }
+  while (true) {
+    const auto count = detail::iov_count(count_);
+    if (const auto rc = ::writev(socket_, reinterpret_cast<const ::iovec*>(buffers_), count); rc > 0) {
+      const auto remaining = count_;
+      if (advance(static_cast<std::size_t>(rc))) {
+        return true;
+      }
+      // Write the next buffers right away when all buffers that fit into the system call were sent.
+      if (remaining - count_ < static_cast<std::size_t>(count)) {
+        return false;
+      }
+      continue;
+    } else if (rc == 0) {
+      return true;
+    }
+    if (errno != EAGAIN && errno != EINTR) {
+      ec_ = errno;
+      return true;
+    }
+    return false;
+  }
+#endif
+  return false;
+}
+
+bool send_buffers::suspend() noexcept {
+  timeout_.start(context_);
+  registration_.start();
+#if ICE_OS_WIN32
+  const auto cancelable = enter(socket_);
+  while (count_ > 0) {
+    const auto socket = socket_.as<SOCKET>();
+    const auto buffers = std::launder(reinterpret_cast<LPWSABUF>(buffers_));
+    const auto count = static_cast<DWORD>(count_);
+    if (::WSASend(socket, buffers, count, &bytes_, 0, get(), nullptr) == SOCKET_ERROR) {
+      if (const auto rc = ::WSAGetLastError(); rc != ERROR_IO_PENDING) {
+        ec_ = rc;
+        break;
+      }
+      leave(cancelable);
+      return true;
+    }
+    if (bytes_ == 0 || advance(bytes_)) {
+      break;
+    }
+  }
+  leave(cancelable);
+  return false;
+#elif ICE_IO_URING
+  const auto count = static_cast<std::uint32_t>(detail::iov_count(count_));
+  return queue(context_, IORING_OP_WRITEV, socket_, buffers_, count);
+#else
+  return queue_send(context_, socket_);
+#endif
+}
+
+bool send_buffers::resume() noexcept {
+#if ICE_OS_WIN32
+  const auto socket = socket_.as<HANDLE>();
+  if (!::GetOverlappedResult(socket, get(), &bytes_, FALSE)) {
+    ec_ = ::GetLastError();
+  } else if (bytes_ > 0 && !advance(bytes_)) {
+    return false;
+  }
+  return true;
+#elif ICE_IO_URING
+  if (const auto rc = get()->res; rc > 0) {
+    return advance(static_cast<std::size_t>(rc));
+  } else if (rc == 0) {
+    return true;
+  } else if (rc == -EAGAIN || rc == -EINTR) {
+    return false;
+  } else {
+    ec_ = -rc;
+  }
+  return true;
 #else
   return await_ready();
 #endif
 }
 
+#if !ICE_OS_WIN32
+
+bool send_file::await_ready() noexcept {
+  if (!ready_send(context_, socket_)) {
+    return false;
+  }
+  while (remaining_ > 0) {
+#  if ICE_OS_LINUX
+    auto offset = static_cast<off_t>(offset_);
+    const auto rc = ::sendfile(socket_, file_, &offset, remaining_);
+    const auto sent = rc > 0 ? static_cast<std::size_t>(rc) : std::size_t(0);
+#  else
+    off_t bytes = 0;
+    const auto rc = ::sendfile(file_, socket_, static_cast<off_t>(offset_), remaining_, nullptr, &bytes, 0);
+    const auto sent = static_cast<std::size_t>(bytes);
+#  endif
+    assert(remaining_ >= sent);
+    offset_ += sent;
+    remaining_ -= sent;
+    size_ += sent;
+    if (rc >= 0) {
+      if (sent == 0) {
+        // The file ended before the range was sent.
+        break;
+      }
+      continue;
+    }
+    if (errno == EINTR) {
+      continue;
+    }
+    if (errno != EAGAIN) {
+      ec_ = errno;
+      break;
+    }
+    return false;
+  }
+  return true;
+}
+
+bool send_file::suspend() noexcept {
+  timeout_.start(context_);
+  registration_.start();
+  return queue_send(context_, socket_);
+}
+
+bool send_file::resume() noexcept {
+#  if ICE_IO_URING
+  if (const auto rc = get()->res; rc < 0) {
+    ec_ = -rc;
+    return true;
+  }
+#  endif
+  return await_ready();
+}
+
+#endif
+
+#if ICE_OS_LINUX
+
+bool send_zerocopy::await_ready() noexcept {
+  assert(!socket_.zerocopy_pending_);
+  socket_.zerocopy_pending_ = true;
+  if (socket_.zerocopy_ == tcp::socket::zerocopy::unknown) {
+    const auto enable = 1;
+    const auto rc = ::setsockopt(socket_.handle(), SOL_SOCKET, SO_ZEROCOPY, &enable, sizeof(enable));
+    socket_.zerocopy_ = rc < 0 ? tcp::socket::zerocopy::unsupported : tcp::socket::zerocopy::enabled;
+  }
+  first_ = socket_.zerocopy_id_;
+  return advance();
+}
+
+bool send_zerocopy::suspend() noexcept {
+  if (sent_) {
+    return queue_error(context_, socket_.handle());
+  }
+  return queue_send(context_, socket_.handle());
+}
+
+bool send_zerocopy::resume() noexcept {
+#  if ICE_IO_URING
+  if (const auto rc = get()->res; rc < 0) {
+    ec_ = -rc;
+    return true;
+  }
+#  endif
+  return advance();
+}
+
+bool send_zerocopy::advance() noexcept {
+  const int handle = socket_.handle();
+  if (!sent_) {
+    if (!ready_send(context_, handle)) {
+      return false;
+    }
+    int flags = socket_.zerocopy_ == tcp::socket::zerocopy::enabled ? MSG_ZEROCOPY : 0;
+    while (buffer_.size > 0) {
+      if (const auto rc = ::send(handle, buffer_.data, buffer_.size, flags); rc > 0) {
+        assert(buffer_.size >= static_cast<std::size_t>(rc));
+        buffer_.data += static_cast<std::size_t>(rc);
+        buffer_.size -= static_cast<std::size_t>(rc);
+        size_ += static_cast<std::size_t>(rc);
+        if (flags) {
+          socket_.zerocopy_id_++;
+          count_++;
+        }
+        continue;
+      } else if (rc == 0) {
+        break;
+      }
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno == ENOBUFS && flags) {
+        // Too many notifications are pending to pin more pages. Copy the data instead.
+        flags = 0;
+        continue;
+      }
+      if (errno != EAGAIN) {
+        send_ec_ = errno;
+        break;
+      }
+      // Notifications queue up while the socket has no space and are reported as errors. Reading them keeps a
+      // level-triggered context from reporting the socket on every wait until it becomes writable.
+      return release() && ec_;
+    }
+    // The pages of the calls that succeeded are in use even when a later call failed.
+    sent_ = true;
+  }
+  if (released_ < count_ && !ready_error(context_, handle)) {
+    return false;
+  }
+  return release();
+}
+
+bool send_zerocopy::release() noexcept {
+  while (released_ < count_) {
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(sock_extended_err) + sizeof(sockaddr_in6))];
+    msghdr msg = {};
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    if (::recvmsg(socket_.handle(), &msg, MSG_ERRQUEUE) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno != EAGAIN) {
+        ec_ = errno;
+        return true;
+      }
+      return false;
+    }
+    for (auto cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+      const auto ip = cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR;
+      const auto ipv6 = cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR;
+      if (!ip && !ipv6) {
+        continue;
+      }
+      sock_extended_err error = {};
+      std::memcpy(&error, CMSG_DATA(cmsg), sizeof(error));
+      if (error.ee_errno != 0 || error.ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+        continue;
+      }
+      // Notifications cover the inclusive range of identifiers from ee_info to ee_data and may include send calls of
+      // earlier operations that failed before they were released. Identifiers wrap around, so they are compared
+      // relative to the first one of this operation.
+      const auto begin = error.ee_info - first_;
+      const auto end = error.ee_data - first_;
+      if (begin > end) {
+        released_ += std::min(end, count_ - 1) + 1;
+      } else if (begin < count_) {
+        released_ += std::min(end, count_ - 1) - begin + 1;
+      }
+    }
+  }
+  return true;
+}
+
+#endif
+
 }  // namespace ice::net::tcp
@@ -22,6 +22,9 @@ socket::socket(ice::context& context, int family, int protocol) : net::socket(co
 
 bool recv::await_ready() noexcept {
 #if ICE_OS_LINUX || ICE_OS_FREEBSD
+  if (!ready_recv(context_, socket_)) {
+    return false;
+  }
   auto& sockaddr = endpoint_.sockaddr();
   auto& size = endpoint_.size();
   size = endpoint_.capacity();
@@ -42,19 +45,24 @@ bool recv::await_ready() noexcept {
 }
 
 bool recv::suspend() noexcept {
+  registration_.start();
 #if ICE_OS_WIN32
   const auto socket = socket_.as<SOCKET>();
   const auto buffer = std::launder(reinterpret_cast<LPWSABUF>(&buffer_));
   auto& sockaddr = endpoint_.sockaddr();
   auto& size = endpoint_.size();
+  const auto cancelable = enter(socket_);
   if (::WSARecvFrom(socket, buffer, 1, &bytes_, &flags_, &sockaddr, &size, get(), nullptr) != SOCKET_ERROR) {
     size_ += bytes_;
+    leave(cancelable);
     return false;
   }
   if (const auto rc = ::WSAGetLastError(); rc != ERROR_IO_PENDING) {
     ec_ = rc;
+    leave(cancelable);
     return false;
   }
+  leave(cancelable);
   return true;
 #else
   return queue_recv(context_, socket_);
@@ -76,6 +84,9 @@ bool recv::resume() noexcept {
 
 bool send::await_ready() noexcept {
 #if ICE_OS_LINUX || ICE_OS_FREEBSD
+  if (!ready_send(context_, socket_)) {
+    return false;
+  }
   const auto& sockaddr = endpoint_.sockaddr();
   const auto size = endpoint_.size();
   if (const auto rc = ::sendto(socket_, buffer_.data, buffer_.size, 0, &sockaddr, size); rc > 0) {
@@ -96,17 +107,20 @@ bool send::await_ready() noexcept {
 }
 
 bool send::suspend() noexcept {
+  registration_.start();
 #if ICE_OS_WIN32
   const auto socket = socket_.as<SOCKET>();
   const auto buffer = std::launder(reinterpret_cast<LPWSABUF>(&buffer_));
   const auto& sockaddr = endpoint_.sockaddr();
   const auto size = endpoint_.size();
+  const auto cancelable = enter(socket_);
   while (buffer_.size > 0) {
     if (::WSASendTo(socket, buffer, 1, &bytes_, 0, &sockaddr, size, get(), nullptr) == SOCKET_ERROR) {
       if (const auto rc = ::WSAGetLastError(); rc != ERROR_IO_PENDING) {
         ec_ = rc;
         break;
       }
+      leave(cancelable);
       return true;
     }
     buffer_.data += bytes_;
@@ -116,6 +130,7 @@ bool send::suspend() noexcept {
       break;
     }
   }
+  leave(cancelable);
   return false;
 #else
   return queue_send(context_, socket_);
@@ -143,6 +158,9 @@ bool send::resume() noexcept {
 
 bool send_some::await_ready() noexcept {
 #if ICE_OS_LINUX || ICE_OS_FREEBSD
+  if (!ready_send(context_, socket_)) {
+    return false;
+  }
   const auto& sockaddr = endpoint_.sockaddr();
   const auto size = endpoint_.size();
   if (const auto rc = ::sendto(socket_, buffer_.data, buffer_.size, 0, &sockaddr, size); rc > 0) {
@@ -163,21 +181,26 @@ bool send_some::await_ready() noexcept {
 }
 
 bool send_some::suspend() noexcept {
+  registration_.start();
 #if ICE_OS_WIN32
   const auto socket = socket_.as<SOCKET>();
   const auto buffer = std::launder(reinterpret_cast<LPWSABUF>(&buffer_));
   const auto& sockaddr = endpoint_.sockaddr();
   const auto size = endpoint_.size();
+  const auto cancelable = enter(socket_);
   if (::WSASendTo(socket, buffer, 1, &bytes_, 0, &sockaddr, size, get(), nullptr) == SOCKET_ERROR) {
     if (const auto rc = ::WSAGetLastError(); rc != ERROR_IO_PENDING) {
       ec_ = rc;
+      leave(cancelable);
       return false;
     }
+    leave(cancelable);
     return true;
   }
   buffer_.data += bytes_;
   buffer_.size -= bytes_;
   size_ += bytes_;
+  leave(cancelable);
   return false;
 #else
   return queue_send(context_, socket_);
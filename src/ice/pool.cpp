@@ -0,0 +1,152 @@
+#include <ice/pool.h>
+#include "deque.h"
+#include <algorithm>
+#include <thread>
+
+namespace ice {
+namespace detail {
+
+class worker {
+public:
+  explicit worker(std::size_t index) noexcept : index(index), state(static_cast<std::uint32_t>(index) * 2 + 1) {
+  }
+
+  // Returns a pseudo-random number for picking steal victims.
+  std::uint32_t random() noexcept {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+  }
+
+  const std::size_t index;
+  std::uint32_t state;
+  detail::deque deque;
+  std::thread thread;
+};
+
+}  // namespace detail
+
+pool::pool(std::size_t size) {
+  if (!size) {
+    size = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  workers_.reserve(size);
+  for (std::size_t i = 0; i < size; i++) {
+    workers_.push_back(std::make_unique<detail::worker>(i));
+  }
+  for (auto& worker : workers_) {
+    worker->thread = std::thread([this, &worker = *worker]() { run(worker); });
+  }
+}
+
+pool::~pool() {
+  {
+    std::lock_guard lock(mutex_);
+    stop_.store(true);
+  }
+  condition_.notify_all();
+  for (auto& worker : workers_) {
+    worker->thread.join();
+  }
+}
+
+void pool::queue(ice::event* ev) noexcept {
+  const auto worker = static_cast<detail::worker*>(index_.get());
+  if (!worker || !worker->deque.push(ev)) {
+    std::lock_guard lock(mutex_);
+    ev->next_ = nullptr;
+    if (tail_) {
+      tail_->next_ = ev;
+    } else {
+      head_ = ev;
+    }
+    tail_ = ev;
+    size_.fetch_add(1, std::memory_order_relaxed);
+  }
+  notify();
+}
+
+void pool::run(detail::worker& worker) noexcept {
+  index_.set(&worker);
+  while (true) {
+    if (const auto ev = find(worker)) {
+      ev->await_resume();
+      continue;
+    }
+    std::unique_lock lock(mutex_);
+    if (stop_.load(std::memory_order_relaxed)) {
+      break;
+    }
+    // Announce the sleeping worker before checking for work, so that threads that queue events after the check
+    // see it and wake it up.
+    sleeping_.fetch_add(1);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (empty()) {
+      condition_.wait(lock);
+    }
+    sleeping_.fetch_sub(1, std::memory_order_relaxed);
+  }
+  index_.set(nullptr);
+}
+
+ice::event* pool::find(detail::worker& worker) noexcept {
+  if (const auto ev = worker.deque.take()) {
+    return ev;
+  }
+  if (const auto ev = take()) {
+    return ev;
+  }
+  if (workers_.size() < 2) {
+    return nullptr;
+  }
+  for (std::size_t i = 0; i < steal_attempts; i++) {
+    const auto index = worker.random() % workers_.size();
+    if (index == worker.index) {
+      continue;
+    }
+    if (const auto ev = workers_[index]->deque.steal()) {
+      return ev;
+    }
+  }
+  return nullptr;
+}
+
+ice::event* pool::take() noexcept {
+  if (!size_.load(std::memory_order_relaxed)) {
+    return nullptr;
+  }
+  std::lock_guard lock(mutex_);
+  const auto ev = head_;
+  if (ev) {
+    head_ = ev->next_;
+    if (!head_) {
+      tail_ = nullptr;
+    }
+    size_.fetch_sub(1, std::memory_order_relaxed);
+  }
+  return ev;
+}
+
+bool pool::empty() const noexcept {
+  if (head_) {
+    return false;
+  }
+  for (const auto& worker : workers_) {
+    if (!worker->deque.empty()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void pool::notify() noexcept {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (sleeping_.load(std::memory_order_relaxed)) {
+    // Taking the lock orders the notification after a sleeping worker checked for work and started to wait.
+    { std::lock_guard lock(mutex_); }
+    condition_.notify_one();
+  }
+}
+
+}  // namespace ice
@@ -0,0 +1,157 @@
+#include "ring.h"
+
+#if ICE_IO_URING
+#  include <algorithm>
+#  include <sys/mman.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+
+namespace ice::detail {
+namespace {
+
+void* map(int handle, std::size_t size, off_t offset) {
+  const auto data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, handle, offset);
+  if (data == MAP_FAILED) {
+    throw ice::system_error(errno, "map context ring");
+  }
+  return data;
+}
+
+template <typename T>
+T* at(void* data, unsigned offset) noexcept {
+  return reinterpret_cast<T*>(static_cast<char*>(data) + offset);
+}
+
+}  // namespace
+
+ring::mapping::~mapping() {
+  if (data) {
+    ::munmap(data, size);
+  }
+}
+
+ring::ring(int handle, const io_uring_params& params) :
+  handle_(handle), ext_arg_(params.features & IORING_FEAT_EXT_ARG) {
+  sq_.size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_.size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    sq_.size = std::max(sq_.size, cq_.size);
+  }
+  sq_.data = map(handle, sq_.size, IORING_OFF_SQ_RING);
+  auto cq_data = sq_.data;
+  if (!(params.features & IORING_FEAT_SINGLE_MMAP)) {
+    cq_.data = map(handle, cq_.size, IORING_OFF_CQ_RING);
+    cq_data = cq_.data;
+  }
+  sqes_.size = params.sq_entries * sizeof(io_uring_sqe);
+  sqes_.data = map(handle, sqes_.size, IORING_OFF_SQES);
+
+  sq_mask_ = *at<unsigned>(sq_.data, params.sq_off.ring_mask);
+  sq_entries_ = *at<unsigned>(sq_.data, params.sq_off.ring_entries);
+  sq_khead_ = at<unsigned>(sq_.data, params.sq_off.head);
+  sq_ktail_ = at<unsigned>(sq_.data, params.sq_off.tail);
+  sq_tail_ = *sq_ktail_;
+  sq_entries_data_ = static_cast<io_uring_sqe*>(sqes_.data);
+
+  // Submission queue entries are always used in order.
+  const auto array = at<unsigned>(sq_.data, params.sq_off.array);
+  for (unsigned i = 0; i < sq_entries_; i++) {
+    array[i] = i;
+  }
+
+  cq_mask_ = *at<unsigned>(cq_data, params.cq_off.ring_mask);
+  cq_khead_ = at<unsigned>(cq_data, params.cq_off.head);
+  cq_ktail_ = at<unsigned>(cq_data, params.cq_off.tail);
+  cq_entries_data_ = at<io_uring_cqe>(cq_data, params.cq_off.cqes);
+}
+
+ring::~ring() = default;
+
+ice::error_code ring::push(const io_uring_sqe& sqe, bool flush) noexcept {
+  std::lock_guard lock(sq_mutex_);
+  while (sq_tail_ - __atomic_load_n(sq_khead_, __ATOMIC_ACQUIRE) >= sq_entries_) {
+    if (const auto ec = enter(pending(), 0); ec && ec != EINTR && ec != EAGAIN && ec != EBUSY) {
+      return ec;
+    }
+  }
+  sq_entries_data_[sq_tail_ & sq_mask_] = sqe;
+  __atomic_store_n(sq_ktail_, ++sq_tail_, __ATOMIC_RELEASE);
+  if (flush) {
+    return enter(pending(), 0);
+  }
+  return {};
+}
+
+ice::error_code ring::submit() noexcept {
+  if (const auto submit = pending()) {
+    return enter(submit, 0);
+  }
+  return {};
+}
+
+ice::error_code ring::wait(int timeout) noexcept {
+  if (timeout == 0) {
+    // Completions are read from the mapped queue, so a poll without entries to submit does not enter the kernel.
+    return submit();
+  }
+  if (timeout < 0) {
+    return enter(pending(), 1);
+  }
+  __kernel_timespec ts = {};
+  ts.tv_sec = timeout / 1000;
+  ts.tv_nsec = (timeout % 1000) * 1000000;
+  if (!ext_arg_) {
+    // Older kernels need a timeout entry. It also completes after the next completion, so none are left behind.
+    io_uring_sqe sqe = {};
+    sqe.opcode = IORING_OP_TIMEOUT;
+    sqe.addr = reinterpret_cast<std::uintptr_t>(&ts);
+    sqe.len = 1;
+    sqe.off = 1;
+    if (const auto ec = push(sqe, false)) {
+      return ec;
+    }
+    return enter(pending(), 1);
+  }
+  if (const auto ec = enter(pending(), 1, &ts); ec && ec != ETIME) {
+    return ec;
+  }
+  return {};
+}
+
+std::size_t ring::pop(io_uring_cqe* entries, std::size_t size) noexcept {
+  std::lock_guard lock(cq_mutex_);
+  auto head = *cq_khead_;
+  const auto tail = __atomic_load_n(cq_ktail_, __ATOMIC_ACQUIRE);
+  std::size_t count = 0;
+  while (head != tail && count < size) {
+    entries[count++] = cq_entries_data_[head & cq_mask_];
+    head++;
+  }
+  __atomic_store_n(cq_khead_, head, __ATOMIC_RELEASE);
+  return count;
+}
+
+ice::error_code ring::enter(unsigned submit, unsigned wait, const __kernel_timespec* timeout) noexcept {
+  auto flags = wait ? IORING_ENTER_GETEVENTS : 0u;
+  if (timeout) {
+    io_uring_getevents_arg arg = {};
+    arg.ts = reinterpret_cast<std::uintptr_t>(timeout);
+    flags |= IORING_ENTER_EXT_ARG;
+    if (::syscall(__NR_io_uring_enter, handle_, submit, wait, flags, &arg, sizeof(arg)) < 0) {
+      return errno;
+    }
+    return {};
+  }
+  if (::syscall(__NR_io_uring_enter, handle_, submit, wait, flags, nullptr, 0) < 0) {
+    return errno;
+  }
+  return {};
+}
+
+unsigned ring::pending() const noexcept {
+  return __atomic_load_n(sq_ktail_, __ATOMIC_RELAXED) - __atomic_load_n(sq_khead_, __ATOMIC_ACQUIRE);
+}
+
+}  // namespace ice::detail
+
+#endif
@@ -0,0 +1,73 @@
+#pragma once
+#include <ice/config.h>
+
+#if ICE_IO_URING
+#  include <ice/error.h>
+#  include <linux/io_uring.h>
+#  include <mutex>
+#  include <cstddef>
+
+namespace ice::detail {
+
+// Submission and completion queues of an io_uring instance.
+class ring {
+public:
+  ring(int handle, const io_uring_params& params);
+
+  ring(ring&& other) = delete;
+  ring& operator=(ring&& other) = delete;
+
+  ring(const ring& other) = delete;
+  ring& operator=(const ring& other) = delete;
+
+  ~ring();
+
+  // Adds an entry to the submission queue.
+  // Submits pending entries when flush is set or the queue is full.
+  ice::error_code push(const io_uring_sqe& sqe, bool flush) noexcept;
+
+  // Submits pending entries.
+  ice::error_code submit() noexcept;
+
+  // Submits pending entries and waits up to timeout milliseconds for at least one completion.
+  // Waits indefinitely when timeout is negative.
+  ice::error_code wait(int timeout) noexcept;
+
+  // Removes up to size entries from the completion queue.
+  std::size_t pop(io_uring_cqe* entries, std::size_t size) noexcept;
+
+private:
+  struct mapping {
+    ~mapping();
+    void* data = nullptr;
+    std::size_t size = 0;
+  };
+
+  ice::error_code enter(unsigned submit, unsigned wait, const __kernel_timespec* timeout = nullptr) noexcept;
+  unsigned pending() const noexcept;
+
+  const int handle_;
+  const bool ext_arg_;
+
+  mapping sq_;
+  mapping cq_;
+  mapping sqes_;
+
+  std::mutex sq_mutex_;
+  unsigned sq_tail_ = 0;
+  unsigned sq_mask_ = 0;
+  unsigned sq_entries_ = 0;
+  unsigned* sq_khead_ = nullptr;
+  unsigned* sq_ktail_ = nullptr;
+  io_uring_sqe* sq_entries_data_ = nullptr;
+
+  std::mutex cq_mutex_;
+  unsigned cq_mask_ = 0;
+  unsigned* cq_khead_ = nullptr;
+  unsigned* cq_ktail_ = nullptr;
+  io_uring_cqe* cq_entries_data_ = nullptr;
+};
+
+}  // namespace ice::detail
+
+#endif
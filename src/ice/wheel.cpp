@@ -0,0 +1,183 @@
+#include "wheel.h"
+#include <algorithm>
+#include <utility>
+
+#if ICE_OS_WIN32
+#  include <intrin.h>
+#endif
+
+namespace ice::detail {
+namespace {
+
+constexpr std::uint64_t level_mask = wheel::level_size - 1;
+
+unsigned first(std::uint64_t mask) noexcept {
+#if ICE_OS_WIN32
+  unsigned long index = 0;
+  _BitScanForward64(&index, mask);
+  return static_cast<unsigned>(index);
+#else
+  return static_cast<unsigned>(__builtin_ctzll(mask));
+#endif
+}
+
+}  // namespace
+
+wheel::wheel() noexcept : epoch_(clock::now()) {
+}
+
+bool wheel::add(timer& timer, clock::time_point time) noexcept {
+  std::lock_guard lock(mutex_);
+  timer.tick_ = 0;
+  if (time > epoch_) {
+    timer.tick_ = static_cast<std::uint64_t>(std::chrono::ceil<std::chrono::milliseconds>(time - epoch_).count());
+  }
+  timer.armed_ = true;
+  insert(timer);
+  size_.fetch_add(1);
+  if (timer.tick_ < wake_.load()) {
+    wake_.store(timer.tick_);
+    return true;
+  }
+  return false;
+}
+
+bool wheel::remove(timer& timer) noexcept {
+  std::lock_guard lock(mutex_);
+  if (!timer.armed_) {
+    return false;
+  }
+  unlink(timer);
+  timer.armed_ = false;
+  size_.fetch_sub(1);
+  return true;
+}
+
+int wheel::timeout() noexcept {
+  // Reset the wake up time before checking for timers, so that timers added concurrently interrupt the wait.
+  wake_.store(tick_never);
+  if (!size_.load()) {
+    return -1;
+  }
+  std::lock_guard lock(mutex_);
+  const auto tick = next();
+  wake_.store(tick);
+  if (tick == tick_never) {
+    return -1;
+  }
+  const auto now = this->now();
+  if (tick <= now) {
+    return 0;
+  }
+  return static_cast<int>(std::min<std::uint64_t>(tick - now, std::numeric_limits<int>::max()));
+}
+
+void wheel::expire() noexcept {
+  if (empty()) {
+    return;
+  }
+  timer* expired = nullptr;
+  const auto collect = [&](timer* entry) noexcept {
+    while (entry) {
+      const auto next = entry->next_;
+      if (entry->tick_ <= current_) {
+        entry->armed_ = false;
+        entry->next_ = expired;
+        expired = entry;
+        size_.fetch_sub(1);
+      } else {
+        insert(*entry);
+      }
+      entry = next;
+    }
+  };
+  std::unique_lock lock(mutex_);
+  const auto now = this->now();
+  while (current_ < now) {
+    // Skip ticks without occupied slots.
+    const auto tick = next();
+    if (tick > now) {
+      current_ = now;
+      break;
+    }
+    current_ = tick;
+    for (std::size_t level = 1; level < level_count; level++) {
+      const auto shift = level_bits * level;
+      if (current_ & ((std::uint64_t(1) << shift) - 1)) {
+        break;
+      }
+      collect(take(level, static_cast<std::size_t>((current_ >> shift) & level_mask)));
+    }
+    collect(take(0, static_cast<std::size_t>(current_ & level_mask)));
+  }
+  lock.unlock();
+  while (expired) {
+    const auto entry = expired;
+    expired = expired->next_;
+    entry->expire();
+  }
+}
+
+std::uint64_t wheel::now() const noexcept {
+  return static_cast<std::uint64_t>(std::chrono::floor<std::chrono::milliseconds>(clock::now() - epoch_).count());
+}
+
+std::uint64_t wheel::next() const noexcept {
+  auto result = tick_never;
+  for (std::size_t level = 0; level < level_count; level++) {
+    const auto mask = masks_[level];
+    if (!mask) {
+      continue;
+    }
+    // Find the distance to the next occupied slot after the current one, which is reached last.
+    const auto shift = level_bits * level;
+    const auto position = current_ >> shift;
+    const auto rotation = static_cast<unsigned>((position + 1) & level_mask);
+    const auto rotated = rotation ? (mask >> rotation) | (mask << (level_size - rotation)) : mask;
+    const auto distance = static_cast<std::uint64_t>(first(rotated)) + 1;
+    result = std::min(result, (position + distance) << shift);
+  }
+  return result;
+}
+
+void wheel::insert(timer& timer) noexcept {
+  // Timers that expire beyond the range of the wheel are placed in the last slot in range and moved again from there.
+  const auto delta = timer.tick_ > current_ ? std::min(timer.tick_ - current_, tick_limit - 1) : 1;
+  std::size_t level = 0;
+  while (level + 1 < level_count && delta >= (std::uint64_t(1) << (level_bits * (level + 1)))) {
+    level++;
+  }
+  const auto index = static_cast<std::size_t>(((current_ + delta) >> (level_bits * level)) & level_mask);
+  const auto slot = level * level_size + index;
+  timer.prev_ = nullptr;
+  timer.next_ = slots_[slot];
+  if (timer.next_) {
+    timer.next_->prev_ = &timer;
+  }
+  timer.slot_ = static_cast<std::uint32_t>(slot);
+  slots_[slot] = &timer;
+  masks_[level] |= std::uint64_t(1) << index;
+}
+
+void wheel::unlink(timer& timer) noexcept {
+  const auto slot = static_cast<std::size_t>(timer.slot_);
+  if (timer.prev_) {
+    timer.prev_->next_ = timer.next_;
+  } else {
+    slots_[slot] = timer.next_;
+  }
+  if (timer.next_) {
+    timer.next_->prev_ = timer.prev_;
+  }
+  if (!slots_[slot]) {
+    masks_[slot / level_size] &= ~(std::uint64_t(1) << (slot % level_size));
+  }
+}
+
+timer* wheel::take(std::size_t level, std::size_t index) noexcept {
+  const auto slot = level * level_size + index;
+  masks_[level] &= ~(std::uint64_t(1) << index);
+  return std::exchange(slots_[slot], nullptr);
+}
+
+}  // namespace ice::detail
@@ -0,0 +1,71 @@
+#pragma once
+#include <ice/context.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+
+namespace ice::detail {
+
+// Hashed hierarchical timer wheel with millisecond ticks.
+//
+// Each level has 64 slots and covers 64 times the range of the level below it. Timers are inserted into the lowest
+// level that covers their expiry time and cascade to lower levels when the slots of the level below wrap around.
+// Inserting and removing a timer takes constant time.
+class wheel {
+public:
+  using clock = std::chrono::steady_clock;
+
+  constexpr static std::size_t level_bits = 6;
+  constexpr static std::size_t level_size = std::size_t(1) << level_bits;
+  constexpr static std::size_t level_count = 6;
+  constexpr static std::uint64_t tick_limit = std::uint64_t(1) << (level_bits * level_count);
+  constexpr static std::uint64_t tick_never = std::numeric_limits<std::uint64_t>::max();
+
+  wheel() noexcept;
+
+  wheel(wheel&& other) = delete;
+  wheel& operator=(wheel&& other) = delete;
+
+  wheel(const wheel& other) = delete;
+  wheel& operator=(const wheel& other) = delete;
+
+  ~wheel() = default;
+
+  // Adds a timer. Returns true when it expires before a waiting thread would wake up.
+  bool add(timer& timer, clock::time_point time) noexcept;
+
+  // Removes a timer. Returns false when the timer is not armed or already expired.
+  bool remove(timer& timer) noexcept;
+
+  // Returns the number of milliseconds until the next slot must be processed or -1 without timers.
+  int timeout() noexcept;
+
+  // Removes expired timers and calls their expire function.
+  void expire() noexcept;
+
+  bool empty() const noexcept {
+    return size_.load(std::memory_order_relaxed) == 0;
+  }
+
+private:
+  std::uint64_t now() const noexcept;
+  std::uint64_t next() const noexcept;
+
+  void insert(timer& timer) noexcept;
+  void unlink(timer& timer) noexcept;
+  timer* take(std::size_t level, std::size_t index) noexcept;
+
+  std::mutex mutex_;
+  const clock::time_point epoch_;
+  std::uint64_t current_ = 0;
+  std::atomic<std::uint64_t> wake_ = tick_never;
+  std::atomic<std::size_t> size_ = 0;
+  std::array<std::uint64_t, level_count> masks_ = {};
+  std::array<timer*, level_count * level_size> slots_ = {};
+};
+
+}  // namespace ice::detail
@@ -1,11 +1,14 @@
 ﻿#include <ice/async.h>
+#include <ice/group.h>
+#include <ice/net/stream.h>
 #include <ice/net/tcp/socket.h>
 #include <ice/scope.h>
-#include <array>
 #include <exception>
 #include <iostream>
 #include <string_view>
 
+constexpr std::string_view g_delimiter = "\r\n\r\n";
+
 constexpr std::string_view g_response =
   "HTTP/1.1 200 OK\r\n"
   "Date: Thu, 19 Apr 2018 04:34:52 GMT\r\n"
@@ -15,7 +18,7 @@ constexpr std::string_view g_response =
   "Content-Length: 0\r\n"
   "\r\n";
 
-ice::task respond(ice::net::tcp::socket& client, ice::async_mutex& mutex, std::string_view data) {
+ice::async<> respond(ice::net::tcp::socket& client, ice::async_mutex& mutex, std::string_view data) {
   const auto lock = co_await mutex.scoped_lock_async();
   const auto sent = co_await client.send(data.data(), data.size());
   if (sent != data.size()) {
@@ -26,40 +29,29 @@ ice::task respond(ice::net::tcp::socket& client, ice::async_mutex& mutex, std::s
 
 ice::task handle(ice::net::tcp::socket client) {
   client.set(ice::net::option::no_delay(true));
-  std::array<char, 1024> buffer;
+  ice::net::stream stream(client);
   ice::async_mutex mutex;
-  bool newline = false;
-  while (true) {
-    const auto size = co_await client.recv(buffer.data(), buffer.size());
-    if (!size) {
-      break;
-    }
-    for (std::size_t i = 0; i < size; i++) {
-      switch (buffer[i]) {
-      case '\r': break;
-      case '\n':
-        if (newline) {
-          respond(client, mutex, g_response);
-          newline = false;
-        } else {
-          newline = true;
-        }
+  ice::async_scope scope;
+  try {
+    // EOF ends the loop, which includes connection resets because tcp::recv reports them as EOF. Requests that end
+    // without the delimiter are incomplete. Other receive errors are thrown and logged below.
+    while (true) {
+      const auto request = co_await stream.read_until(g_delimiter);
+      if (request.size() < g_delimiter.size() || request.substr(request.size() - g_delimiter.size()) != g_delimiter) {
         break;
-      default: newline = false; break;
       }
+      scope.spawn(respond(client, mutex, g_response));
     }
   }
-  co_await mutex.lock_async();  // wait until all send operations finish
+  catch (const std::exception& e) {
+    std::cerr << "could not read request from " << client << ": " << e.what() << std::endl;
+  }
+  co_await scope.join();  // wait until all send operations finish
   co_return;
 }
 
-ice::task server(ice::context& context) {
-  const auto se = ice::on_scope_exit([&]() { context.stop(); });
-  ice::net::endpoint endpoint("127.0.0.1", 8080);
-  ice::net::tcp::socket socket(context, endpoint.family());
-  socket.set(ice::net::option::reuse_address(true));
-  socket.bind(endpoint);
-  socket.listen();
+ice::task server(ice::context_group& group, ice::net::tcp::socket& socket) {
+  const auto se = ice::on_scope_exit([&]() { group.stop(); });
   while (true) {
     handle(co_await socket.accept());
   }
@@ -68,9 +60,18 @@ ice::task server(ice::context& context) {
 
 int main() {
   try {
-    ice::context context;
-    server(context);
-    context.run();
+    // Each context accepts connections on its own listening socket and serves them on its own processor.
+#if ICE_OS_WIN32
+    ice::context_group group(1);
+#else
+    ice::context_group group;
+#endif
+    auto sockets = ice::net::tcp::listen(group, ice::net::endpoint("127.0.0.1", 8080));
+    for (auto& socket : sockets) {
+      server(group, socket);
+    }
+    group.start();
+    group.join();
   }
   catch (const std::exception& e) {
     std::cerr << e.what() << std::endl;